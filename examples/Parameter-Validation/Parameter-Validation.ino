@@ -147,6 +147,12 @@ void setup() {
   // The second parameter should either be 0 or 1. We use our custom validateLEDState() validator for this:
   nodeSwitch->addURLParamValidator(1, &validateLEDState);
 
+  // Note: Simple formal checks can also be declared in the path itself, like
+  // "/led/*{uint}/*{0|1}". The router then checks the parameters while it searches
+  // the node, and requests that do not match continue with the next candidate (or
+  // the 404 node) instead of getting a 400 Bad Request. Validators are still useful
+  // for checks that depend on your application, like validateLEDID().
+
   // Not found node
   ResourceNode * node404 = new ResourceNode("", "GET", &handle404);
 
@@ -272,7 +272,9 @@ void handleURLParam(HTTPRequest * req, HTTPResponse * res) {
   res->println("\n\nChange the parameters in the URL to see how they get parsed!");
 
   // Note: If you have objects that are identified by an ID, you may also use
-  // ResourceParameters::getUrlParameterInt(int) for convenience
+  // ResourceParameters::getUrlParameterInt(int) for convenience, or
+  // ResourceParameters::getUrlParameterInt32(int, int32_t&), which returns false
+  // if the parameter is not a valid number
 }
 
 // For details to this function, see the Static-Page example
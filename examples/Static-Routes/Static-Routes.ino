@@ -0,0 +1,185 @@
+/**
+ * Example for the ESP32 HTTP(S) Webserver
+ *
+ * IMPORTANT NOTE:
+ * To run this script, your need to
+ *  1) Enter your WiFi SSID and PSK below this comment
+ *  2) Make sure to have certificate data available. You will find a
+ *     shell script and instructions to do so in the library folder
+ *     under extras/
+ *
+ * This script will install an HTTPS Server on your ESP32 with the following
+ * functionalities:
+ *  - Show simple page on web server root (GET and HEAD)
+ *  - Switch one of four LEDs on or off, URL: /led/<id>/on or /led/<id>/off
+ *    (POST)
+ *  - 404 for everything else
+ *
+ * Unlike the other examples, the routes are not created as ResourceNodes in
+ * setup(). They are declared as a constexpr table, which the compiler builds
+ * and places in flash. This needs no heap memory and no work at startup, which
+ * is useful for firmware with a fixed set of URLs.
+ */
+
+// TODO: Configure your WiFi here
+#define WIFI_SSID "<your ssid goes here>"
+#define WIFI_PSK  "<your pre-shared key goes here>"
+
+// Include certificate data (see note above)
+#include "cert.h"
+#include "private_key.h"
+
+// We will use wifi
+#include <WiFi.h>
+
+// Includes for the server
+#include <HTTPSServer.hpp>
+#include <SSLCert.hpp>
+#include <HTTPRequest.hpp>
+#include <HTTPResponse.hpp>
+#include <StaticRouteTable.hpp>
+
+// The HTTPS Server comes in a separate namespace. For easier use, include it here.
+using namespace httpsserver;
+
+// Create an SSL certificate object from the files included above
+SSLCert cert = SSLCert(
+  example_crt_DER, example_crt_DER_len,
+  example_key_DER, example_key_DER_len
+);
+
+// Create an SSL-enabled server that uses the certificate
+// The contstructor takes some more parameters, but we go for default values here.
+HTTPSServer secureServer = HTTPSServer(&cert);
+
+// The GPIOs of the LEDs
+const int LED_PINS[] = {16, 17, 18, 19};
+
+// We declare some handler functions (definition at the end of the file)
+void handleRoot(HTTPRequest * req, HTTPResponse * res);
+void handleLED(HTTPRequest * req, HTTPResponse * res);
+void handle404(HTTPRequest * req, HTTPResponse * res);
+
+// The routes of the server. Each route links a path to the HTTP methods it
+// accepts and the handler function. Paths use the same syntax as for
+// ResourceNodes, so "/*" is a URL parameter.
+// A route can serve several methods. Requests for a known path with another
+// method are answered with "405 Method Not Allowed".
+constexpr StaticRoute ROUTES[] = {
+  StaticRoute("/", METHOD_GET | METHOD_HEAD, &handleRoot),
+  StaticRoute("/led/*/on", METHOD_POST, &handleLED),
+  StaticRoute("/led/*/off", METHOD_POST, &handleLED)
+};
+
+// The table is what is passed to the server
+constexpr StaticRouteTable ROUTE_TABLE(ROUTES);
+
+void setup() {
+  // For logging
+  Serial.begin(115200);
+
+  for(int i = 0; i < 4; i++) {
+    pinMode(LED_PINS[i], OUTPUT);
+  }
+
+  // Connect to WiFi
+  Serial.println("Setting up WiFi");
+  WiFi.begin(WIFI_SSID, WIFI_PSK);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print(".");
+    delay(500);
+  }
+  Serial.print("Connected. IP=");
+  Serial.println(WiFi.localIP());
+
+  // Add the routes to the server. The table is not copied.
+  secureServer.setStaticRoutes(&ROUTE_TABLE);
+
+  // Static routes and ResourceNodes can be mixed. The default node is still
+  // created at runtime.
+  secureServer.setDefaultNode(new ResourceNode("", "GET", &handle404));
+
+  Serial.println("Starting server...");
+  secureServer.start();
+  if (secureServer.isRunning()) {
+    Serial.println("Server ready.");
+  }
+}
+
+void loop() {
+  // This call will let the server do its work
+  secureServer.loop();
+
+  // Other code would go here...
+  delay(1);
+}
+
+void handleRoot(HTTPRequest * req, HTTPResponse * res) {
+  res->setHeader("Content-Type", "text/html");
+
+  // HEAD requests get the same headers, but no body
+  if (req->getMethodId() == METHOD_HEAD) {
+    return;
+  }
+
+  res->println("<!DOCTYPE html>");
+  res->println("<html>");
+  res->println("<head><title>Static Routes</title></head>");
+  res->println("<body>");
+  for(int i = 0; i < 4; i++) {
+    res->print("<form method=\"post\" action=\"/led/");
+    res->print(i);
+    res->print(digitalRead(LED_PINS[i]) ? "/off\">" : "/on\">");
+    res->print("<button type=\"submit\">Switch LED ");
+    res->print(i);
+    res->print(digitalRead(LED_PINS[i]) ? " off" : " on");
+    res->println("</button></form>");
+  }
+  res->println("</body>");
+  res->println("</html>");
+}
+
+void handleLED(HTTPRequest * req, HTTPResponse * res) {
+  // The form sends a body, which we do not need
+  req->discardRequestBody();
+
+  // The LED id is the first URL parameter. The typed accessor returns false
+  // if it is not a number.
+  int32_t id;
+  if (!req->getParams()->getUrlParameterInt32(0, id) || id < 0 || id > 3) {
+    res->setStatusCode(400);
+    res->setStatusText("Bad Request");
+    res->println("Invalid LED id");
+    return;
+  }
+
+  // Both routes use this handler, so we check the end of the path
+  std::string path = req->getRequestString();
+  digitalWrite(LED_PINS[id], path.compare(path.length() - 3, 3, "/on") == 0 ? HIGH : LOW);
+
+  // Go back to the root page
+  res->setStatusCode(303);
+  res->setStatusText("See Other");
+  res->setHeader("Location", "/");
+  res->println("Redirecting...");
+}
+
+void handle404(HTTPRequest * req, HTTPResponse * res) {
+  // Discard request body, if we received any
+  // We do this, as this is the default node and may also server POST/PUT requests
+  req->discardRequestBody();
+
+  // Set the response status
+  res->setStatusCode(404);
+  res->setStatusText("Not Found");
+
+  // Set content type of the response
+  res->setHeader("Content-Type", "text/html");
+
+  // Write a tiny HTTP page
+  res->println("<!DOCTYPE html>");
+  res->println("<html>");
+  res->println("<head><title>Not Found</title></head>");
+  res->println("<body><h1>404 Not Found</h1><p>The requested resource was not found on this server.</p></body>");
+  res->println("</html>");
+}
@@ -0,0 +1,124 @@
+/**
+ * Benchmark: Accept latency for bursts of parallel connections
+ *
+ * Simulates a browser that opens several connections at once: A burst of
+ * clients connects and sends a request, then the server runs its main loop
+ * (loop() followed by delay(1), like in the examples) until every client has
+ * received its response. The benchmark reports the number of server loops and
+ * the time until the last client was served.
+ *
+ * To compare with accepting one client per loop, configure the build with
+ * -DCMAKE_CXX_FLAGS=-DHTTPS_MAX_ACCEPTS_PER_LOOP=1
+ *
+ * Usage: bench_accept [port]
+ */
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <vector>
+
+#include <HTTPServer.hpp>
+#include <HTTPRequest.hpp>
+#include <HTTPResponse.hpp>
+
+using namespace httpsserver;
+
+static const int ROUNDS = 20;
+
+static double wallTimeUs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static int connectClient(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  return fd;
+}
+
+void handleRoot(HTTPRequest *, HTTPResponse * res) {
+  res->setHeader("Content-Type", "text/plain");
+  res->print("Hello World!");
+}
+
+int main(int argc, char ** argv) {
+  uint16_t port = argc > 1 ? atoi(argv[1]) : 18300;
+  const int burstSizes[] = {1, 4, 6, 8};
+  const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+
+  HTTPServer server(port, 8);
+  server.registerNode(new ResourceNode("/", "GET", &handleRoot));
+  if (!server.start()) {
+    Serial.println("Could not start server");
+    return 1;
+  }
+
+  Serial.printf("accepts/loop: %d\n", HTTPS_MAX_ACCEPTS_PER_LOOP);
+  Serial.printf("%-8s %-14s %-14s %s\n", "burst", "loops (mean)", "ms (mean)", "ms (max)");
+  for(int b = 0; b < 4; b++) {
+    int burstSize = burstSizes[b];
+    double totalLoops = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+
+    for(int r = 0; r < ROUNDS; r++) {
+      double start = wallTimeUs();
+      std::vector<int> clients;
+      for(int i = 0; i < burstSize; i++) {
+        int fd = connectClient(port);
+        if (fd < 0) {
+          Serial.println("Could not connect client");
+          return 1;
+        }
+        send(fd, request, sizeof(request) - 1, 0);
+        clients.push_back(fd);
+      }
+
+      // Run the main loop until every client has got (the start of) its response
+      std::vector<bool> served(burstSize, false);
+      int servedCount = 0;
+      int loops = 0;
+      while(servedCount < burstSize && loops < 10000) {
+        server.loop();
+        loops++;
+        for(int i = 0; i < burstSize; i++) {
+          char buf[256];
+          if (!served[i] && recv(clients[i], buf, sizeof(buf), 0) > 0) {
+            served[i] = true;
+            servedCount++;
+          }
+        }
+        if (servedCount < burstSize) {
+          delay(1);
+        }
+      }
+      double elapsedMs = (wallTimeUs() - start) / 1000.0;
+      totalLoops += loops;
+      totalMs += elapsedMs;
+      if (elapsedMs > maxMs) maxMs = elapsedMs;
+
+      for(int i = 0; i < burstSize; i++) {
+        close(clients[i]);
+      }
+      // Let the server clean up the connections before the next round
+      for(int i = 0; i < 20; i++) {
+        server.loop();
+        delay(1);
+      }
+    }
+    Serial.printf("%-8d %-14.2f %-14.2f %.2f\n", burstSize, totalLoops / ROUNDS, totalMs / ROUNDS, maxMs);
+  }
+
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * Benchmark: CPU cost of HTTPServer::loop() with idle keep-alive connections
+ *
+ * Opens 8, 32 and 64 client connections that do not send any data and
+ * measures the CPU time that is spent per server loop iteration. This is the
+ * cost that a server pays permanently while browsers keep connections open.
+ *
+ * Usage: bench_idle_loop [port]
+ */
+
+#include <sys/resource.h>
+#include <vector>
+
+#include <HTTPServer.hpp>
+
+using namespace httpsserver;
+
+static const int ITERATIONS = 20000;
+
+static double cpuTimeUs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+    usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static int connectClient(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char ** argv) {
+  uint16_t port = argc > 1 ? atoi(argv[1]) : 18200;
+  const int clientCounts[] = {8, 32, 64};
+
+  Serial.printf("%-12s %-14s %s\n", "connections", "us/iteration", "iterations");
+  for(int c = 0; c < 3; c++) {
+    int clientCount = clientCounts[c];
+    HTTPServer server(port + c, clientCount);
+    if (!server.start()) {
+      Serial.println("Could not start server");
+      return 1;
+    }
+
+    std::vector<int> clients;
+    for(int i = 0; i < clientCount; i++) {
+      int fd = connectClient(port + c);
+      if (fd < 0) {
+        Serial.println("Could not connect client");
+        return 1;
+      }
+      clients.push_back(fd);
+      // Let the server accept the connection
+      server.loop();
+    }
+    for(int i = 0; i < clientCount; i++) {
+      server.loop();
+    }
+
+    double start = cpuTimeUs();
+    for(int i = 0; i < ITERATIONS; i++) {
+      server.loop();
+    }
+    double elapsed = cpuTimeUs() - start;
+    Serial.printf("%-12d %-14.3f %d\n", clientCount, elapsed / ITERATIONS, ITERATIONS);
+
+    for(size_t i = 0; i < clients.size(); i++) {
+      close(clients[i]);
+    }
+    server.stop();
+  }
+  return 0;
+}
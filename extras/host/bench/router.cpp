@@ -0,0 +1,141 @@
+/**
+ * Benchmark: Resolving request paths with 10 to 160 registered routes
+ *
+ * Registers REST-like routes (static ones and ones with URL parameters) and
+ * resolves paths that are spread over all of them. Compares the linear scan
+ * over all nodes that ResourceResolver used before with the radix trie it uses
+ * now. Results are given in nanoseconds per lookup.
+ *
+ * Usage: bench_router
+ */
+
+#include <chrono>
+#include <vector>
+
+#include <ResourceResolver.hpp>
+
+using namespace httpsserver;
+
+static const int ROUNDS = 20000;
+
+void handleNothing(HTTPRequest *, HTTPResponse *) {
+}
+
+static double nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The matching loop of the previous ResourceResolver::resolveNode()
+static HTTPNode * resolveLinear(std::vector<HTTPNode*> &nodes, const std::string &method, const std::string &resourceName, ResourceParameters * params) {
+  for(std::vector<HTTPNode*>::iterator node = nodes.begin(); node != nodes.end(); ++node) {
+    params->resetUrlParameters();
+    if (((ResourceNode*)*node)->_method != method) {
+      continue;
+    }
+    const std::string nodepath = ((*node)->_path);
+    if (!((*node)->hasUrlParameter())) {
+      if (nodepath == resourceName) {
+        return *node;
+      }
+      continue;
+    }
+    bool didMatch = true;
+    size_t urlIdx = 0;
+    size_t nodeIdx = 0;
+    for (int pIdx = 0; didMatch && pIdx < (*node)->getUrlParamCount(); pIdx++) {
+      size_t pOffset = (*node)->getParamIdx(pIdx);
+      size_t staticLength = pOffset-nodeIdx;
+      if (nodepath.substr(nodeIdx, staticLength).compare(resourceName.substr(urlIdx, staticLength))!=0) {
+        didMatch = false;
+      } else {
+        nodeIdx += staticLength + 1;
+        urlIdx  += staticLength;
+        if (nodeIdx == nodepath.length()) {
+          params->setUrlParameter(pIdx, resourceName.substr(urlIdx));
+        } else {
+          size_t terminatorPosition = resourceName.find(nodepath[nodeIdx], urlIdx);
+          if (terminatorPosition != std::string::npos) {
+            params->setUrlParameter(pIdx, resourceName.substr(urlIdx, terminatorPosition-urlIdx));
+            urlIdx = terminatorPosition;
+          } else {
+            didMatch = false;
+          }
+        }
+      }
+    }
+    if (didMatch && nodeIdx < nodepath.length()) {
+      size_t staticLength = nodepath.length()-nodeIdx;
+      if (nodepath.substr(nodeIdx, staticLength).compare(resourceName.substr(urlIdx, staticLength))!=0 ||
+          urlIdx + staticLength < resourceName.length()) {
+        didMatch = false;
+      }
+    }
+    if (didMatch) {
+      return *node;
+    }
+  }
+  return NULL;
+}
+
+int main() {
+  const int routeCounts[] = {10, 20, 40, 80, 160};
+
+  Serial.printf("%-8s %-14s %-14s\n", "routes", "linear ns", "trie ns");
+  for(int c = 0; c < 5; c++) {
+    int routeCount = routeCounts[c];
+    ResourceResolver resolver;
+    std::vector<HTTPNode*> nodes;
+    std::vector<std::string> paths;
+    std::vector<std::string> methods;
+
+    // Each resource has a collection, an item and a property route
+    for(int i = 0; nodes.size() < (size_t)routeCount; i++) {
+      std::string resource = "/api/v1/resource" + intToString(i);
+      const char * patterns[] = {"", "/*", "/*/property"};
+      const char * requests[] = {"", "/1234", "/1234/property"};
+      for(int p = 0; p < 3 && nodes.size() < (size_t)routeCount; p++) {
+        const char * method = (p == 1 && i % 2 == 1) ? "POST" : "GET";
+        HTTPNode * node = new ResourceNode(resource + patterns[p], method, &handleNothing);
+        nodes.push_back(node);
+        resolver.registerNode(node);
+        paths.push_back(resource + requests[p]);
+        methods.push_back(method);
+      }
+    }
+
+    ResourceParameters params;
+    double start = nowNs();
+    for(int r = 0; r < ROUNDS; r++) {
+      size_t i = r % paths.size();
+      if (resolveLinear(nodes, methods[i], paths[i], &params) == NULL) {
+        Serial.println("Linear scan did not match");
+        return 1;
+      }
+    }
+    double linear = (nowNs() - start) / ROUNDS;
+
+    // Like for a connection, the parameters are allocated from an arena
+    RequestArena arena;
+    start = nowNs();
+    for(int r = 0; r < ROUNDS; r++) {
+      size_t i = r % paths.size();
+      {
+        ResolvedResource resolved(&arena);
+        resolver.resolveNode(methods[i], paths[i], resolved, HANDLER_CALLBACK);
+        if (!resolved.didMatch()) {
+          Serial.println("Trie did not match");
+          return 1;
+        }
+      }
+      arena.reset();
+    }
+    double trie = (nowNs() - start) / ROUNDS;
+
+    Serial.printf("%-8d %-14.0f %-14.0f\n", routeCount, linear, trie);
+    for(size_t i = 0; i < nodes.size(); i++) {
+      delete nodes[i];
+    }
+  }
+  return 0;
+}
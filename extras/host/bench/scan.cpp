@@ -0,0 +1,100 @@
+/**
+ * Benchmark: Scanning for delimiters in the HTTP parser
+ *
+ * Compares the byte-by-byte loop that the parser used before with memchr(),
+ * findCharWordwise() (the SWAR kernel used on the ESP32) and findChar() (which
+ * is memchr() on this host) for typical line lengths. The delimiter is always
+ * the last byte of the line. Results are given in bytes per cycle (x86 hosts)
+ * or bytes per nanosecond (other hosts).
+ *
+ * Usage: bench_scan
+ */
+
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "bytes/cycle"
+static inline uint64_t ticks() {
+  return __rdtsc();
+}
+#else
+#define BENCH_UNIT "bytes/ns"
+static inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#include <util.hpp>
+
+using namespace httpsserver;
+
+typedef const char * (ScanFunction)(const char * data, size_t length, char c);
+
+static const char * findCharByteLoop(const char * data, size_t length, char c) {
+  for(size_t i = 0; i < length; i++) {
+    if (data[i] == c) {
+      return data + i;
+    }
+  }
+  return NULL;
+}
+
+static const char * findCharMemchr(const char * data, size_t length, char c) {
+  return (const char *)memchr(data, c, length);
+}
+
+// Prevents the compiler from optimizing the scan away
+static volatile uintptr_t sink;
+
+static double measure(ScanFunction * scan, const std::vector<char> &buffer, size_t lineLength) {
+  const size_t lines = buffer.size() / lineLength;
+  const int rounds = 50;
+  double best = 0;
+
+  // Take the best of several runs to reduce the influence of other processes
+  for(int run = 0; run < 10; run++) {
+    uint64_t start = ticks();
+    for(int r = 0; r < rounds; r++) {
+      for(size_t l = 0; l < lines; l++) {
+        // Vary the alignment of the lines by starting at an odd offset
+        sink = (uintptr_t)scan(&buffer[l * lineLength + 1], lineLength - 1, '\r');
+      }
+    }
+    uint64_t elapsed = ticks() - start;
+    double result = (double)rounds * lines * (lineLength - 1) / elapsed;
+    if (result > best) {
+      best = result;
+    }
+  }
+  return best;
+}
+
+int main() {
+  const size_t lineLengths[] = {8, 16, 32, 64, 128, 512, 1024};
+  const size_t bufferSize = 1 << 16;
+
+  Serial.printf("Unit: %s\n", BENCH_UNIT);
+  Serial.printf("%-8s %10s %10s %10s %10s\n", "length", "byteloop", "memchr", "wordwise", "findChar");
+  for(size_t i = 0; i < sizeof(lineLengths) / sizeof(lineLengths[0]); i++) {
+    size_t lineLength = lineLengths[i];
+
+    // Lines of header-like text that end with \r
+    std::vector<char> buffer(bufferSize);
+    for(size_t j = 0; j < bufferSize; j++) {
+      buffer[j] = 'a' + (j % 26);
+      if (j % lineLength == lineLength - 1) {
+        buffer[j] = '\r';
+      }
+    }
+
+    Serial.printf("%-8u %10.3f %10.3f %10.3f %10.3f\n", (unsigned)lineLength,
+      measure(&findCharByteLoop, buffer, lineLength),
+      measure(&findCharMemchr, buffer, lineLength),
+      measure(&findCharWordwise, buffer, lineLength),
+      measure(&findChar, buffer, lineLength));
+  }
+  return 0;
+}
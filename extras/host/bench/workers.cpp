@@ -0,0 +1,160 @@
+/**
+ * Benchmark: Request throughput with 1, 2 and 4 workers
+ *
+ * Starts an HTTPServer with N workers, each run by its own thread calling
+ * loop(worker) followed by delay(1), like a task per core on the ESP32. A fixed
+ * number of keep-alive clients then send requests for a few seconds, and the
+ * benchmark reports the requests per second for each N.
+ *
+ * The handler either burns CPU time (mode "cpu") or waits (mode "wait", like a
+ * handler that blocks on I/O). In mode "wait", more workers help even on a
+ * single core. In mode "cpu", they can only help on a host with several cores,
+ * so check the core count (nproc) before reading the results.
+ *
+ * Usage: bench_workers [cpu|wait] [port]
+ */
+
+#include <sys/time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <HTTPServer.hpp>
+#include <HTTPRequest.hpp>
+#include <HTTPResponse.hpp>
+
+using namespace httpsserver;
+
+static const int CLIENTS = 16;
+static const int DURATION_MS = 3000;
+static const unsigned long WORK_US = 500;
+
+static bool waitMode = false;
+
+static double wallTimeUs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+void handleWork(HTTPRequest *, HTTPResponse * res) {
+  if (waitMode) {
+    delayMicroseconds(WORK_US);
+  } else {
+    // Keep the core busy, e.g. like a handler that renders a template
+    unsigned long start = micros();
+    volatile uint32_t x = 0;
+    while((uint32_t)(micros() - start) < WORK_US) {
+      x = x * 31 + 7;
+    }
+  }
+  res->setHeader("Content-Type", "text/plain");
+  res->print("done");
+}
+
+static int connectClient(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Reads one response with Content-Length from the socket. Returns false if the connection is closed.
+static bool readResponse(int fd) {
+  std::string data;
+  char buf[512];
+  size_t headEnd = std::string::npos;
+  size_t total = 0;
+  while(headEnd == std::string::npos || data.size() < total) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    data.append(buf, n);
+    if (headEnd == std::string::npos && (headEnd = data.find("\r\n\r\n")) != std::string::npos) {
+      size_t cl = data.find("Content-Length: ");
+      total = headEnd + 4 + (cl != std::string::npos ? atoi(data.c_str() + cl + 16) : 0);
+    }
+  }
+  return true;
+}
+
+static void runClient(uint16_t port, std::atomic<bool> * stop, std::atomic<unsigned long> * count) {
+  const char request[] = "GET /work HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+  int fd = connectClient(port);
+  while(fd >= 0 && !*stop) {
+    if (send(fd, request, sizeof(request) - 1, 0) <= 0 || !readResponse(fd)) {
+      // The connection has been closed (e.g. by a timeout), open a new one
+      close(fd);
+      fd = connectClient(port);
+      continue;
+    }
+    (*count)++;
+  }
+  if (fd >= 0) close(fd);
+}
+
+static void runWorker(HTTPServer * server, uint8_t worker, std::atomic<bool> * stop) {
+  while(!*stop) {
+    server->loop(worker);
+    delay(1);
+  }
+}
+
+int main(int argc, char ** argv) {
+  waitMode = argc > 1 && strcmp(argv[1], "wait") == 0;
+  uint16_t port = argc > 2 ? atoi(argv[2]) : 18400;
+  const uint8_t workerCounts[] = {1, 2, 4};
+
+  Serial.printf("mode: %s, %d clients, %lu us per request, %u cores\n",
+    waitMode ? "wait" : "cpu", CLIENTS, WORK_US, std::thread::hardware_concurrency());
+  Serial.printf("%-8s %-12s %s\n", "workers", "req/s", "speedup");
+  double baseline = 0;
+  for(int w = 0; w < 3; w++) {
+    uint8_t workerCount = workerCounts[w];
+    HTTPServer server(port + w, CLIENTS, 0, workerCount);
+    server.registerNode(new ResourceNode("/work", "GET", &handleWork));
+    if (!server.start()) {
+      Serial.println("Could not start server");
+      return 1;
+    }
+
+    std::atomic<bool> stopWorkers(false);
+    std::vector<std::thread> workers;
+    for(uint8_t i = 0; i < workerCount; i++) {
+      workers.push_back(std::thread(runWorker, &server, i, &stopWorkers));
+    }
+
+    std::atomic<bool> stopClients(false);
+    std::atomic<unsigned long> count(0);
+    std::vector<std::thread> clients;
+    double start = wallTimeUs();
+    for(int i = 0; i < CLIENTS; i++) {
+      clients.push_back(std::thread(runClient, port + w, &stopClients, &count));
+    }
+    delay(DURATION_MS);
+    stopClients = true;
+    unsigned long requests = count;
+    double seconds = (wallTimeUs() - start) / 1e6;
+    for(size_t i = 0; i < clients.size(); i++) {
+      clients[i].join();
+    }
+
+    // stop() runs the workers itself, so their threads have to be finished before
+    stopWorkers = true;
+    for(size_t i = 0; i < workers.size(); i++) {
+      workers[i].join();
+    }
+    server.stop();
+
+    double rate = requests / seconds;
+    if (w == 0) baseline = rate;
+    Serial.printf("%-8d %-12.0f %.2fx\n", workerCount, rate, rate / baseline);
+  }
+  return 0;
+}
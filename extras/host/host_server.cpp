@@ -0,0 +1,166 @@
+/**
+ * Host build of the ESP32 HTTP(S) Webserver
+ *
+ * This program runs the unmodified library as a Linux process, so that the
+ * parser, router and TLS paths can be profiled (e.g. with perf) and load
+ * tested without a board.
+ *
+ * Usage:
+ *   host_server [httpPort] [httpsPort cert.der key.der]
+ *
+ * Without arguments, a plain HTTP server is started on port 8080. If a port
+ * and DER-encoded certificate and private key are given (see create_cert.sh
+ * in the extras folder), an HTTPS server is started in addition.
+ *
+ * Functionality is the same as in the Static-Page and Put-Post-Echo examples:
+ *  - Show simple page on web server root
+ *  - Echo the request body for POST /echo
+ *  - 404 for everything else
+ */
+
+#include <signal.h>
+#include <vector>
+
+#include <HTTPServer.hpp>
+#include <HTTPSServer.hpp>
+#include <SSLCert.hpp>
+#include <HTTPRequest.hpp>
+#include <HTTPResponse.hpp>
+
+using namespace httpsserver;
+
+static volatile bool keepRunning = true;
+
+static void handleSignal(int) {
+  keepRunning = false;
+}
+
+static bool readFile(const char * path, std::vector<unsigned char> &data) {
+  FILE * f = fopen(path, "rb");
+  if (f == NULL) {
+    return false;
+  }
+  unsigned char buf[512];
+  size_t n;
+  while((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(f);
+  return !data.empty();
+}
+
+void handleRoot(HTTPRequest *, HTTPResponse * res) {
+  res->setHeader("Content-Type", "text/html");
+  res->println("<!DOCTYPE html>");
+  res->println("<html>");
+  res->println("<head><title>Hello World!</title></head>");
+  res->println("<body>");
+  res->println("<h1>Hello World!</h1>");
+  res->print("<p>Your server is running for ");
+  res->print((int)(millis()/1000), DEC);
+  res->println(" seconds.</p>");
+  res->println("</body>");
+  res->println("</html>");
+}
+
+void handleEcho(HTTPRequest * req, HTTPResponse * res) {
+  res->setHeader("Content-Type", "text/plain");
+  byte buffer[256];
+  while(!(req->requestComplete())) {
+    size_t s = req->readBytes(buffer, 256);
+    res->write(buffer, s);
+  }
+}
+
+void handle404(HTTPRequest * req, HTTPResponse * res) {
+  req->discardRequestBody();
+  res->setStatusCode(404);
+  res->setStatusText("Not Found");
+  res->setHeader("Content-Type", "text/html");
+  res->println("<!DOCTYPE html>");
+  res->println("<html>");
+  res->println("<head><title>Not Found</title></head>");
+  res->println("<body><h1>404 Not Found</h1><p>The requested resource was not found on this server.</p></body>");
+  res->println("</html>");
+}
+
+static void registerNodes(HTTPServer &server) {
+  server.registerNode(new ResourceNode("/", "GET", &handleRoot));
+  server.registerNode(new ResourceNode("/echo", "POST", &handleEcho));
+  server.setDefaultNode(new ResourceNode("", "GET", &handle404));
+}
+
+int main(int argc, char ** argv) {
+  signal(SIGINT, handleSignal);
+  signal(SIGTERM, handleSignal);
+
+  uint16_t httpPort = argc > 1 ? atoi(argv[1]) : 8080;
+
+  HTTPServer insecureServer(httpPort, 16);
+  registerNodes(insecureServer);
+
+  SSLCert * cert = NULL;
+  HTTPSServer * secureServer = NULL;
+  std::vector<unsigned char> certData, keyData;
+  if (argc > 4) {
+    if (!readFile(argv[3], certData) || !readFile(argv[4], keyData)) {
+      Serial.println("Could not read certificate or private key");
+      return 1;
+    }
+    cert = new SSLCert(certData.data(), certData.size(), keyData.data(), keyData.size());
+    secureServer = new HTTPSServer(cert, atoi(argv[2]), 16);
+    registerNodes(*secureServer);
+  }
+
+  Serial.println("Starting server...");
+  insecureServer.start();
+  if (secureServer != NULL) {
+    secureServer->start();
+  }
+  if (!insecureServer.isRunning() || (secureServer != NULL && !secureServer->isRunning())) {
+    Serial.println("Could not start server");
+    return 1;
+  }
+  Serial.println("Server ready.");
+  Serial.flush();
+
+  while(keepRunning) {
+    insecureServer.loop();
+    if (secureServer != NULL) {
+      secureServer->loop();
+    }
+    delay(1);
+  }
+
+  Serial.println("Stopping server...");
+  Serial.printf("HTTP: %lu responses, %lu socket writes\n",
+    insecureServer.getResponseCount(), insecureServer.getSocketWriteCount());
+  if (secureServer != NULL) {
+    Serial.printf("HTTPS: %lu responses, %lu TLS records\n",
+      secureServer->getResponseCount(), secureServer->getSocketWriteCount());
+    Serial.printf("TLS handshakes: %lu full, %lu resumed\n",
+      secureServer->getFullHandshakeCount(), secureServer->getResumedHandshakeCount());
+    Serial.printf("TLS session cache: %lu of %lu entries, %lu bytes\n", secureServer->getCachedSessionCount(),
+      secureServer->getSessionCacheSize(), (unsigned long)secureServer->getSessionCacheMemory());
+  }
+
+  // Let the requests in progress finish, but don't accept new ones
+  insecureServer.drain();
+  if (secureServer != NULL) {
+    secureServer->drain();
+  }
+  while(insecureServer.isRunning() || (secureServer != NULL && secureServer->isRunning())) {
+    insecureServer.loop();
+    if (secureServer != NULL) {
+      secureServer->loop();
+    }
+    delay(1);
+  }
+  Serial.println("Server stopped.");
+
+  if (secureServer != NULL) {
+    delete secureServer;
+    delete cert;
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+/**
+ * Minimal Arduino core shim for building the library as a Linux process.
+ *
+ * Only the parts of the Arduino/ESP32 core that are used by the library are
+ * provided: basic types, millis()/delay(), Print and the Serial object.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/** Milliseconds since process start. Wraps at 32 bit, like on the ESP32 */
+unsigned long millis();
+/** Microseconds since process start. Wraps at 32 bit, like on the ESP32 */
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// The ESP-IDF logging macros are mapped to the Arduino core's log_x() functions, which drop the tag
+#define ESP_LOGE(tag, ...) do {} while (0)
+#define ESP_LOGW(tag, ...) do {} while (0)
+#define ESP_LOGI(tag, ...) do {} while (0)
+#define ESP_LOGD(tag, ...) do {} while (0)
+#define ESP_LOGV(tag, ...) do {} while (0)
+
+/**
+ * \brief Host version of the Arduino Print interface
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+
+  size_t printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+  size_t print(const char[]);
+  size_t print(char);
+  size_t print(unsigned char, int = DEC);
+  size_t print(int, int = DEC);
+  size_t print(unsigned int, int = DEC);
+  size_t print(long, int = DEC);
+  size_t print(unsigned long, int = DEC);
+  size_t print(double, int = 2);
+
+  size_t println(const char[]);
+  size_t println(char);
+  size_t println(unsigned char, int = DEC);
+  size_t println(int, int = DEC);
+  size_t println(unsigned int, int = DEC);
+  size_t println(long, int = DEC);
+  size_t println(unsigned long, int = DEC);
+  size_t println(double, int = 2);
+  size_t println(void);
+
+private:
+  size_t printNumber(unsigned long, uint8_t);
+};
+
+/**
+ * \brief Serial port replacement that writes to stdout
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void flush();
+  size_t write(uint8_t);
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HOST_ARDUINO_H_ */
@@ -0,0 +1,23 @@
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+
+#include <stdint.h>
+
+/**
+ * Host shim for the system functions of ESP-IDF.
+ *
+ * Only the free heap size is provided. The process has no fixed heap, so the
+ * memory that is available to the system is reported instead.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t esp_get_free_heap_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_SYSTEM_H_ */
@@ -0,0 +1,38 @@
+#ifndef HOST_HWCRYPTO_SHA_H_
+#define HOST_HWCRYPTO_SHA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// OpenSSL declares a SHA1() function, which collides with the enum value of the same name. We
+// include it first and rename the enum value, so both can be used in the same translation unit.
+#include <openssl/sha.h>
+
+/**
+ * Host shim for the ESP32 hardware SHA accelerator.
+ *
+ * Only SHA1 is implemented (in software), as it is the only algorithm the
+ * library requires (Sec-WebSocket-Accept).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  ESP_SHA1 = 0,
+  SHA2_256,
+  SHA2_384,
+  SHA2_512,
+  SHA_INVALID = -1,
+} esp_sha_type;
+
+#define SHA1 ESP_SHA1
+
+void esp_sha(esp_sha_type type, const unsigned char *input, size_t ilen, unsigned char *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_HWCRYPTO_SHA_H_ */
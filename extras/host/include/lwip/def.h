@@ -0,0 +1,7 @@
+#ifndef HOST_LWIP_DEF_H_
+#define HOST_LWIP_DEF_H_
+
+// htons(), ntohs(), htonl(), ntohl()
+#include <arpa/inet.h>
+
+#endif /* HOST_LWIP_DEF_H_ */
@@ -0,0 +1,7 @@
+#ifndef HOST_LWIP_INET_H_
+#define HOST_LWIP_INET_H_
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#endif /* HOST_LWIP_INET_H_ */
@@ -0,0 +1,7 @@
+#ifndef HOST_LWIP_NETDB_H_
+#define HOST_LWIP_NETDB_H_
+
+// Host shim: lwIP mirrors the BSD socket API, so the POSIX headers can be used directly
+#include <netdb.h>
+
+#endif /* HOST_LWIP_NETDB_H_ */
@@ -0,0 +1,15 @@
+#ifndef HOST_LWIP_SOCKETS_H_
+#define HOST_LWIP_SOCKETS_H_
+
+// Host shim: lwIP mirrors the BSD socket API, so the POSIX headers can be used directly
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#endif /* HOST_LWIP_SOCKETS_H_ */
@@ -0,0 +1,25 @@
+#ifndef HOST_MBEDTLS_BASE64_H_
+#define HOST_MBEDTLS_BASE64_H_
+
+#include <stddef.h>
+
+/**
+ * Host shim for the base64 part of mbedTLS. Signatures and return codes follow
+ * the original mbedtls/base64.h
+ */
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL               -0x002A
+#define MBEDTLS_ERR_BASE64_INVALID_CHARACTER              -0x002C
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MBEDTLS_BASE64_H_ */
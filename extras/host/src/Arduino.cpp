@@ -0,0 +1,188 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+#include <signal.h>
+
+namespace {
+
+const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+/**
+ * Process setup that is done once at startup:
+ * - lwIP reports a write to a closed socket as error code, a Linux process would be terminated by
+ *   SIGPIPE instead. We ignore the signal, so the library sees the same behavior as on the board.
+ * - Serial output is line-buffered, so log lines show up immediately (like on a serial console).
+ */
+struct HostSetup {
+  HostSetup() {
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+  }
+} hostSetup;
+
+}
+
+unsigned long millis() {
+  auto elapsed = std::chrono::steady_clock::now() - startTime;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+unsigned long micros() {
+  auto elapsed = std::chrono::steady_clock::now() - startTime;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+HardwareSerial Serial;
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (write(*buffer++)) {
+      n++;
+    } else {
+      break;
+    }
+  }
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[64];
+  va_list arg;
+  va_start(arg, format);
+  int len = vsnprintf(buf, sizeof(buf), format, arg);
+  va_end(arg);
+  if (len < 0) {
+    return 0;
+  }
+  if ((size_t)len < sizeof(buf)) {
+    return write((const uint8_t *)buf, len);
+  }
+  char * temp = new char[len + 1];
+  va_start(arg, format);
+  vsnprintf(temp, len + 1, format, arg);
+  va_end(arg);
+  len = write((const uint8_t *)temp, len);
+  delete[] temp;
+  return len;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    unsigned long m = n;
+    n /= base;
+    char c = m - base * n;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+size_t Print::print(const char str[]) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char b, int base) {
+  return print((unsigned long)b, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 10 && n < 0) {
+    return print('-') + printNumber(-(unsigned long)n, 10);
+  }
+  return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  return printf("%.*f", digits, n);
+}
+
+size_t Print::println(void) {
+  return print("\r\n");
+}
+
+size_t Print::println(const char c[]) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(char c) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(unsigned char b, int base) {
+  size_t n = print(b, base);
+  return n + println();
+}
+
+size_t Print::println(int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(double num, int digits) {
+  size_t n = print(num, digits);
+  return n + println();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
@@ -0,0 +1,98 @@
+#include "mbedtls/base64.h"
+
+#include <stdint.h>
+
+namespace {
+
+const unsigned char base64EncMap[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int base64DecValue(unsigned char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+}
+
+extern "C" int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+  if (slen == 0) {
+    *olen = 0;
+    return 0;
+  }
+
+  // Output length including the terminating null byte (like mbedTLS)
+  size_t n = ((slen + 2) / 3) * 4 + 1;
+  if (dst == NULL || dlen < n) {
+    *olen = n;
+    return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  }
+
+  unsigned char *p = dst;
+  size_t i = 0;
+  for (; i + 3 <= slen; i += 3) {
+    uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i+1] << 8) | src[i+2];
+    *p++ = base64EncMap[(v >> 18) & 0x3F];
+    *p++ = base64EncMap[(v >> 12) & 0x3F];
+    *p++ = base64EncMap[(v >> 6) & 0x3F];
+    *p++ = base64EncMap[v & 0x3F];
+  }
+  if (i < slen) {
+    uint32_t v = (uint32_t)src[i] << 16;
+    if (i + 1 < slen) {
+      v |= (uint32_t)src[i+1] << 8;
+    }
+    *p++ = base64EncMap[(v >> 18) & 0x3F];
+    *p++ = base64EncMap[(v >> 12) & 0x3F];
+    *p++ = (i + 1 < slen) ? base64EncMap[(v >> 6) & 0x3F] : '=';
+    *p++ = '=';
+  }
+
+  *olen = p - dst;
+  *p = 0;
+  return 0;
+}
+
+extern "C" int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+  // First pass: validate and count the payload characters
+  size_t chars = 0;
+  size_t pad = 0;
+  for (size_t i = 0; i < slen; i++) {
+    if (src[i] == '=') {
+      if (++pad > 2) {
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+      }
+    } else if (base64DecValue(src[i]) < 0 || pad > 0) {
+      return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    } else {
+      chars++;
+    }
+  }
+  if ((chars + pad) % 4 != 0) {
+    return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+  }
+
+  size_t n = (chars * 6) / 8;
+  if (dst == NULL || dlen < n) {
+    *olen = n;
+    return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  }
+
+  uint32_t acc = 0;
+  int bits = 0;
+  unsigned char *p = dst;
+  for (size_t i = 0; i < slen && src[i] != '='; i++) {
+    acc = (acc << 6) | base64DecValue(src[i]);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      *p++ = (unsigned char)(acc >> bits);
+    }
+  }
+
+  *olen = p - dst;
+  return 0;
+}
@@ -0,0 +1,11 @@
+#include "esp_system.h"
+
+#include <unistd.h>
+
+/**
+ * Available physical memory of the system, limited to 32 bit like the heap size on the ESP32
+ */
+uint32_t esp_get_free_heap_size(void) {
+  unsigned long long available = (unsigned long long)sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+  return available > UINT32_MAX ? UINT32_MAX : (uint32_t)available;
+}
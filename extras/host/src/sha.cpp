@@ -0,0 +1,94 @@
+#include "hwcrypto/sha.h"
+
+#include <string.h>
+
+/**
+ * Software SHA-1 (FIPS 180-4) replacing the ESP32 hardware accelerator on the host
+ */
+
+namespace {
+
+inline uint32_t rol(uint32_t value, unsigned int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+void sha1Block(uint32_t state[5], const unsigned char block[64]) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)block[4*i] << 24) | ((uint32_t)block[4*i+1] << 16) |
+           ((uint32_t)block[4*i+2] << 8) | ((uint32_t)block[4*i+3]);
+  }
+  for (int i = 16; i < 80; i++) {
+    w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+  for (int i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+    uint32_t temp = rol(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rol(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+}
+
+extern "C" void esp_sha(esp_sha_type type, const unsigned char *input, size_t ilen, unsigned char *output) {
+  if (type != SHA1) {
+    // Not required by the library
+    memset(output, 0, 20);
+    return;
+  }
+
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+  size_t offset = 0;
+  for (; offset + 64 <= ilen; offset += 64) {
+    sha1Block(state, input + offset);
+  }
+
+  // Padding: 0x80, zeros, 64 bit big-endian length in bits
+  unsigned char tail[128];
+  size_t rest = ilen - offset;
+  memcpy(tail, input + offset, rest);
+  tail[rest] = 0x80;
+  size_t tailLength = (rest + 1 + 8 <= 64) ? 64 : 128;
+  memset(tail + rest + 1, 0, tailLength - rest - 1);
+  uint64_t bitLength = (uint64_t)ilen * 8;
+  for (int i = 0; i < 8; i++) {
+    tail[tailLength - 1 - i] = (unsigned char)(bitLength >> (8 * i));
+  }
+  sha1Block(state, tail);
+  if (tailLength == 128) {
+    sha1Block(state, tail + 64);
+  }
+
+  for (int i = 0; i < 5; i++) {
+    output[4*i]   = (unsigned char)(state[i] >> 24);
+    output[4*i+1] = (unsigned char)(state[i] >> 16);
+    output[4*i+2] = (unsigned char)(state[i] >> 8);
+    output[4*i+3] = (unsigned char)(state[i]);
+  }
+}
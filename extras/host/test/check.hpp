@@ -0,0 +1,38 @@
+#ifndef HOST_TEST_CHECK_HPP_
+#define HOST_TEST_CHECK_HPP_
+
+/**
+ * Minimal assertion helpers for the host tests
+ *
+ * CHECK() reports a failed condition with its location and continues, so one
+ * run shows all failures. Each test's main() returns checkResult(), which is
+ * non-zero if any check has failed, so CTest marks the test as failed.
+ */
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      checkFailures++; \
+    } \
+  } while(0)
+
+#define CHECK_EQ(actual, expected) do { \
+    if (!((actual) == (expected))) { \
+      fprintf(stderr, "%s:%d: CHECK failed: %s == %s\n", __FILE__, __LINE__, #actual, #expected); \
+      checkFailures++; \
+    } \
+  } while(0)
+
+static inline int checkResult() {
+  if (checkFailures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", checkFailures);
+    return 1;
+  }
+  return 0;
+}
+
+#endif /* HOST_TEST_CHECK_HPP_ */
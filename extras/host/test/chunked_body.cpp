@@ -0,0 +1,231 @@
+/**
+ * Test: Decoding of chunked request bodies in HTTPRequest
+ *
+ * Feeds request bodies through a connection stub, in one piece and byte by
+ * byte, and checks the decoded data, the detection of the transfer coding,
+ * the rejection of invalid framing and of other transfer codings, and that
+ * data after the body (a pipelined request) is left in the buffer.
+ *
+ * Usage: test_chunked_body
+ */
+
+#include <string>
+
+#include <HTTPRequest.hpp>
+#include <HTTPHeaders.hpp>
+#include <ResourceParameters.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+/** Connection that serves the data that has been passed to feed() */
+class StubConnection : public ConnectionContext {
+public:
+  StubConnection(): _pos(0), _inputClosed(false), _errorCount(0), _clientErrorCount(0) {}
+
+  void feed(std::string const &data) {
+    _data.append(data);
+  }
+
+  std::string remaining() {
+    return _data.substr(_pos);
+  }
+
+  virtual void signalRequestError() { _errorCount++; }
+  virtual void signalClientError() { _clientErrorCount++; }
+  virtual void signalClientClose() { _inputClosed = true; }
+  virtual size_t getCacheSize() { return 0; }
+  virtual bool canSendChunked() { return false; }
+  virtual RequestArena * getArena() { return NULL; }
+
+  virtual size_t readBuffer(byte * buffer, size_t length) {
+    size_t available = _data.size() - _pos;
+    if (length > available) {
+      length = available;
+    }
+    memcpy(buffer, _data.data() + _pos, length);
+    _pos += length;
+    return length;
+  }
+
+  virtual size_t peekBuffer(byte ** data) {
+    *data = (byte*)_data.data() + _pos;
+    return _data.size() - _pos;
+  }
+
+  virtual void consumeBuffer(size_t length) { _pos += length; }
+  virtual size_t pendingBufferSize() { return _data.size() - _pos; }
+  virtual bool isInputClosed() { return _inputClosed; }
+  virtual size_t writeBuffer(byte *, size_t length) { return length; }
+  virtual void flushBuffer() {}
+  virtual bool isSecure() { return false; }
+
+  std::string _data;
+  size_t _pos;
+  bool _inputClosed;
+  // Number of server errors (500) and client errors (400) that have been signaled
+  int _errorCount;
+  int _clientErrorCount;
+};
+
+/** A request on the stub connection with the given body headers */
+struct TestRequest {
+  TestRequest(const char * transferEncoding, const char * contentLength = NULL) {
+    if (transferEncoding != NULL) {
+      headers.set(HTTPSpan("Transfer-Encoding"), HTTPSpan(transferEncoding));
+    }
+    if (contentLength != NULL) {
+      headers.set(HTTPSpan("Content-Length"), HTTPSpan(contentLength));
+    }
+    request = new HTTPRequest(&con, &headers, NULL, NULL, HTTPSpan("POST"), METHOD_POST, &params, HTTPSpan("/"));
+  }
+
+  ~TestRequest() {
+    delete request;
+  }
+
+  /** Reads until the body is complete, with reads of at most readSize bytes */
+  std::string readAll(size_t readSize) {
+    std::string body;
+    byte buffer[64];
+    for(int i = 0; i < 10000 && !request->requestComplete(); i++) {
+      size_t n = request->readBytes(buffer, readSize);
+      body.append((char*)buffer, n);
+    }
+    return body;
+  }
+
+  StubConnection con;
+  HTTPHeaders headers;
+  ResourceParameters params;
+  HTTPRequest * request;
+};
+
+static const char * BODY = "5;name=value\r\nhello\r\nA\r\n0123456789\r\n0\r\nX-Trailer: 1\r\n\r\n";
+static const char * NEXT_REQUEST = "GET / HTTP/1.1\r\n\r\n";
+
+static void testCompleteBody() {
+  TestRequest t("chunked");
+  t.con.feed(std::string(BODY) + NEXT_REQUEST);
+  CHECK_EQ(t.readAll(64), "hello0123456789");
+  CHECK(t.request->requestComplete());
+  CHECK_EQ(t.con.remaining(), NEXT_REQUEST);
+  CHECK_EQ(t.con._errorCount, 0);
+}
+
+static void testBodySplitAcrossReads() {
+  // Every byte arrives on its own, so each state of the framing parser has to wait for more data
+  TestRequest t("chunked");
+  std::string body(BODY);
+  std::string decoded;
+  byte buffer[3];
+  for(size_t i = 0; i < body.size(); i++) {
+    CHECK(!t.request->requestComplete());
+    t.con.feed(body.substr(i, 1));
+    decoded.append((char*)buffer, t.request->readBytes(buffer, sizeof(buffer)));
+  }
+  t.con.feed(NEXT_REQUEST);
+  CHECK_EQ(decoded, "hello0123456789");
+  CHECK(t.request->requestComplete());
+  CHECK_EQ(t.con.remaining(), NEXT_REQUEST);
+  CHECK_EQ(t.con._errorCount, 0);
+  CHECK_EQ(t.con._clientErrorCount, 0);
+}
+
+static void testSmallReads() {
+  TestRequest t("chunked");
+  t.con.feed(std::string(BODY) + NEXT_REQUEST);
+  CHECK_EQ(t.readAll(4), "hello0123456789");
+  CHECK_EQ(t.con.remaining(), NEXT_REQUEST);
+}
+
+static void testDiscard() {
+  TestRequest t("chunked");
+  t.con.feed(std::string(BODY) + NEXT_REQUEST);
+  t.request->discardRequestBody();
+  CHECK(t.request->requestComplete());
+  CHECK_EQ(t.con.remaining(), NEXT_REQUEST);
+}
+
+static void testContentLengthIsZero() {
+  // The remaining size of the current chunk is no meaningful content length
+  TestRequest t("chunked");
+  t.con.feed("A\r\n01234");
+  byte buffer[2];
+  CHECK_EQ(t.request->readBytes(buffer, sizeof(buffer)), 2u);
+  CHECK_EQ(t.request->getContentLength(), 0u);
+}
+
+static void expectFramingError(const char * body) {
+  TestRequest t("chunked");
+  t.con.feed(body);
+  t.readAll(64);
+  if (t.con._clientErrorCount != 1) {
+    fprintf(stderr, "No framing error for body: %s\n", body);
+  }
+  // Invalid framing is the client's fault
+  CHECK_EQ(t.con._clientErrorCount, 1);
+  CHECK_EQ(t.con._errorCount, 0);
+  CHECK(t.request->requestComplete());
+}
+
+static void testInvalidFraming() {
+  expectFramingError("zz\r\nhello\r\n0\r\n\r\n");
+  expectFramingError("\r\nhello\r\n0\r\n\r\n");
+  expectFramingError("5\r\nhelloX\r\n0\r\n\r\n");
+  expectFramingError("0x5\r\nhello\r\n0\r\n\r\n");
+  expectFramingError("fffffffffffffffffffffff\r\n");
+}
+
+static void testTransferCodings() {
+  const char * chunked[] = {"chunked", "Chunked", "gzip, chunked", "gzip,chunked", "gzip ,\tchunked "};
+  for(size_t i = 0; i < sizeof(chunked) / sizeof(chunked[0]); i++) {
+    TestRequest t(chunked[i], "3");
+    CHECK(HTTPRequest::hasValidTransferEncoding(&t.headers));
+    t.con.feed("5\r\nhello\r\n0\r\n\r\n");
+    CHECK_EQ(t.readAll(64), "hello");
+  }
+
+  // If chunked is not the last coding, the length of the body is unknown. Content-Length must not
+  // be used instead, the request has to be rejected.
+  const char * notChunked[] = {"xchunked", "chunked, gzip", "chunkedx", "gzip", ""};
+  for(size_t i = 0; i < sizeof(notChunked) / sizeof(notChunked[0]); i++) {
+    TestRequest t(notChunked[i], "0");
+    if (HTTPRequest::hasValidTransferEncoding(&t.headers)) {
+      fprintf(stderr, "Transfer coding is accepted: %s\n", notChunked[i]);
+    }
+    CHECK(!HTTPRequest::hasValidTransferEncoding(&t.headers));
+    // Should such a request be passed to a handler anyway, nothing is read from the connection
+    t.con.feed("5\r\nhello\r\n0\r\n\r\n");
+    CHECK(t.request->requestComplete());
+    CHECK_EQ(t.readAll(64), "");
+    CHECK_EQ(t.con.remaining(), "5\r\nhello\r\n0\r\n\r\n");
+  }
+
+  // Requests without Transfer-Encoding are fine
+  TestRequest t(NULL, "3");
+  CHECK(HTTPRequest::hasValidTransferEncoding(&t.headers));
+}
+
+static void testInputClosed() {
+  // A body that is cut off must not make the handler wait forever
+  TestRequest t("chunked");
+  t.con.feed("5\r\nhel");
+  CHECK_EQ(t.readAll(64), "hel");
+  CHECK(!t.request->requestComplete());
+  t.con.signalClientClose();
+  CHECK(t.request->requestComplete());
+}
+
+int main() {
+  testCompleteBody();
+  testBodySplitAcrossReads();
+  testSmallReads();
+  testDiscard();
+  testContentLengthIsZero();
+  testInvalidFraming();
+  testTransferCodings();
+  testInputClosed();
+  return checkResult();
+}
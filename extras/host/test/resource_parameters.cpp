@@ -0,0 +1,199 @@
+/**
+ * Test: Parsing and decoding of request parameters in ResourceParameters
+ *
+ * Splits query strings into parameters and checks the percent-decoding of
+ * names and values ("%xx" and "+"), including malformed escape sequences,
+ * which are kept as they are. Also checks that values are only copied if
+ * they contain escape sequences, with and without a RequestArena, and the
+ * typed accessors.
+ *
+ * Usage: test_resource_parameters
+ */
+
+#include <string>
+
+#include <ResourceParameters.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+/** Returns the decoded value of the parameter, or "<unset>" */
+static std::string value(ResourceParameters &params, const char * name) {
+  HTTPSpan v;
+  if (!params.getRequestParameterSpan(HTTPSpan(name), v)) {
+    return "<unset>";
+  }
+  return v.str();
+}
+
+/** Decodes str as the value of a request parameter */
+static std::string decoded(const char * str) {
+  std::string query = std::string("v=") + str;
+  ResourceParameters params;
+  params.setQueryString(HTTPSpan(query));
+  return value(params, "v");
+}
+
+static void testDecoding() {
+  CHECK_EQ(decoded("plain"), "plain");
+  CHECK_EQ(decoded("a%20b"), "a b");
+  CHECK_EQ(decoded("a+b+"), "a b ");
+  CHECK_EQ(decoded("%41%42%43"), "ABC");
+  CHECK_EQ(decoded("%4a%4A"), "JJ");
+  CHECK_EQ(decoded("%2B"), "+");
+  CHECK_EQ(decoded("%25"), "%");
+  CHECK_EQ(decoded("%C3%A4"), "\xc3\xa4");
+  CHECK_EQ(decoded("%00"), std::string("\0", 1));
+  // The decoded '%' does not start another escape sequence
+  CHECK_EQ(decoded("%2541"), "%41");
+}
+
+static void testMalformedEscapes() {
+  // Invalid or incomplete escape sequences are copied as they are
+  CHECK_EQ(decoded("%"), "%");
+  CHECK_EQ(decoded("%4"), "%4");
+  CHECK_EQ(decoded("100%"), "100%");
+  CHECK_EQ(decoded("%zz"), "%zz");
+  CHECK_EQ(decoded("%4g"), "%4g");
+  CHECK_EQ(decoded("%g4"), "%g4");
+  CHECK_EQ(decoded("%%41"), "%A");
+  CHECK_EQ(decoded("a%2"), "a%2");
+  CHECK_EQ(decoded("%+"), "% ");
+}
+
+static void testSplitting() {
+  ResourceParameters params;
+  params.setQueryString(HTTPSpan("a=1&&flag&b=&na%6De=x+y&a=2&=empty&c=%3D%26&"));
+
+  CHECK_EQ(value(params, "a"), "1");
+  // A parameter without '=' has an empty value
+  CHECK(params.isRequestParameterSet("flag"));
+  CHECK_EQ(value(params, "flag"), "");
+  CHECK_EQ(value(params, "b"), "");
+  // Names are decoded as well
+  CHECK_EQ(value(params, "name"), "x y");
+  CHECK_EQ(value(params, "na%6De"), "<unset>");
+  // Encoded separators are part of the value
+  CHECK_EQ(value(params, "c"), "=&");
+  CHECK_EQ(value(params, ""), "empty");
+  CHECK_EQ(value(params, "missing"), "<unset>");
+  CHECK(!params.isRequestParameterSet("missing"));
+  CHECK_EQ(params.getRequestParameter("missing"), "");
+
+  // Names are case-sensitive
+  CHECK_EQ(value(params, "A"), "<unset>");
+
+  // A new query string replaces the parameters
+  params.setQueryString(HTTPSpan("z=26"));
+  CHECK_EQ(value(params, "a"), "<unset>");
+  CHECK_EQ(value(params, "z"), "26");
+  params.setQueryString(HTTPSpan());
+  CHECK_EQ(value(params, "z"), "<unset>");
+}
+
+static void checkCopies(RequestArena * arena) {
+  const char * query = "plain=abc&enc=a%20b";
+  ResourceParameters params(arena);
+  params.setQueryString(HTTPSpan(query));
+
+  // Values without escape sequences refer to the query string
+  HTTPSpan plain;
+  CHECK(params.getRequestParameterSpan(HTTPSpan("plain"), plain));
+  CHECK(plain.data() == query + 6);
+
+  // Decoded values are copied once and then returned again
+  HTTPSpan enc;
+  HTTPSpan again;
+  CHECK(params.getRequestParameterSpan(HTTPSpan("enc"), enc));
+  CHECK(params.getRequestParameterSpan(HTTPSpan("enc"), again));
+  CHECK(enc.data() < query || enc.data() >= query + strlen(query));
+  CHECK(again.data() == enc.data());
+  CHECK_EQ(enc.str(), "a b");
+
+  // Parameters set by the application are neither decoded nor taken from the query string
+  params.setRequestParameter(HTTPSpan("set"), HTTPSpan("a%20b+c"));
+  CHECK_EQ(value(params, "set"), "a%20b+c");
+  CHECK_EQ(value(params, "plain"), "abc");
+}
+
+static void testCopies() {
+  checkCopies(NULL);
+  RequestArena arena(64);
+  checkCopies(&arena);
+  CHECK(arena.getUsed() > 0);
+  arena.reset();
+}
+
+static void testTypedValues() {
+  ResourceParameters params;
+  params.setQueryString(HTTPSpan("i=%2D42&big=4294967296&max=2147483647&over=2147483648&f=1.5e3&t=On&n=no&x=12abc"));
+
+  int32_t i32 = 7;
+  CHECK(params.getRequestParameterInt32(HTTPSpan("i"), i32));
+  CHECK_EQ(i32, -42);
+  CHECK(params.getRequestParameterInt32(HTTPSpan("max"), i32));
+  CHECK_EQ(i32, 2147483647);
+  // Out of range and invalid values leave the value unchanged
+  CHECK(!params.getRequestParameterInt32(HTTPSpan("over"), i32));
+  CHECK(!params.getRequestParameterInt32(HTTPSpan("x"), i32));
+  CHECK(!params.getRequestParameterInt32(HTTPSpan("missing"), i32));
+  CHECK_EQ(i32, 2147483647);
+
+  int64_t i64 = 0;
+  CHECK(params.getRequestParameterInt64(HTTPSpan("big"), i64));
+  CHECK_EQ(i64, 4294967296LL);
+
+  float f = 0;
+  CHECK(params.getRequestParameterFloat(HTTPSpan("f"), f));
+  CHECK_EQ(f, 1500.0f);
+  CHECK(!params.getRequestParameterFloat(HTTPSpan("x"), f));
+
+  bool b = false;
+  CHECK(params.getRequestParameterBool(HTTPSpan("t"), b));
+  CHECK_EQ(b, true);
+  CHECK(params.getRequestParameterBool(HTTPSpan("n"), b));
+  CHECK_EQ(b, false);
+  CHECK(!params.getRequestParameterBool(HTTPSpan("x"), b));
+
+  // The old accessor returns 0 for anything that is no number
+  CHECK_EQ(params.getRequestParameterInt("i"), -42);
+  CHECK_EQ(params.getRequestParameterInt("missing"), 0);
+}
+
+static void testInt64Limits() {
+  int64_t v = 0;
+  CHECK(ResourceParameters::parseInt64(HTTPSpan("9223372036854775807"), v));
+  CHECK_EQ(v, INT64_MAX);
+  CHECK(ResourceParameters::parseInt64(HTTPSpan("-9223372036854775808"), v));
+  CHECK_EQ(v, INT64_MIN);
+  CHECK(!ResourceParameters::parseInt64(HTTPSpan("9223372036854775808"), v));
+  CHECK(!ResourceParameters::parseInt64(HTTPSpan("-"), v));
+  CHECK(!ResourceParameters::parseInt64(HTTPSpan(""), v));
+  CHECK(!ResourceParameters::parseInt64(HTTPSpan(" 1"), v));
+  CHECK_EQ(v, INT64_MIN);
+}
+
+static void testUrlParameters() {
+  // URL parameters are not decoded
+  ResourceParameters params;
+  params.setUrlParameter(0, HTTPSpan("a%20b"));
+  params.setUrlParameter(1, HTTPSpan("17"));
+  CHECK_EQ(params.getUrlParameter(0), "a%20b");
+  int32_t v = 0;
+  CHECK(params.getUrlParameterInt32(1, v));
+  CHECK_EQ(v, 17);
+  params.resetUrlParameters();
+  CHECK(params.getUrlParameterSpan(0).empty());
+}
+
+int main() {
+  testDecoding();
+  testMalformedEscapes();
+  testSplitting();
+  testCopies();
+  testTypedValues();
+  testInt64Limits();
+  testUrlParameters();
+  return checkResult();
+}
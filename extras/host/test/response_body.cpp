@@ -0,0 +1,181 @@
+/**
+ * Test: Framing of keep-alive response bodies in HTTPResponse
+ *
+ * Writes responses through a connection stub with a small keep-alive cache
+ * and checks the headers and body that reach the connection: a body that fits
+ * into the cache gets a Content-Length, a larger one is sent in chunks, or as
+ * it is if the handler has set Content-Length itself, as both headers must
+ * not be sent together. Also checks when the connection can be kept alive.
+ *
+ * Usage: test_response_body
+ */
+
+#include <string>
+
+#include <HTTPResponse.hpp>
+#include <RequestArena.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+/** Size of the stub's keep-alive cache */
+#define CACHE_SIZE 16
+
+/** Connection that collects the data written to it */
+class StubConnection : public ConnectionContext {
+public:
+  StubConnection(bool http11): _http11(http11), _arena(256) {}
+
+  virtual void signalRequestError() {}
+  virtual void signalClientError() {}
+  virtual void signalClientClose() {}
+  virtual size_t getCacheSize() { return CACHE_SIZE; }
+  virtual bool canSendChunked() { return _http11; }
+  virtual RequestArena * getArena() { return &_arena; }
+
+  virtual size_t readBuffer(byte *, size_t) { return 0; }
+  virtual size_t peekBuffer(byte **) { return 0; }
+  virtual void consumeBuffer(size_t) {}
+  virtual size_t pendingBufferSize() { return 0; }
+  virtual bool isInputClosed() { return false; }
+  virtual size_t writeBuffer(byte * buffer, size_t length) {
+    _written.append((char*)buffer, length);
+    return length;
+  }
+  virtual void flushBuffer() {}
+  virtual bool isSecure() { return false; }
+
+  bool _http11;
+  RequestArena _arena;
+  std::string _written;
+};
+
+/** A response on the stub connection, split into head and body once it is finalized */
+struct TestResponse {
+  TestResponse(bool http11 = true): con(http11) {
+    response = new HTTPResponse(&con);
+  }
+
+  ~TestResponse() {
+    delete response;
+    con._arena.reset();
+  }
+
+  void write(std::string const &data) {
+    response->printStd(data);
+  }
+
+  void finalize() {
+    response->finalize();
+    size_t end = con._written.find("\r\n\r\n");
+    head = con._written.substr(0, end + 2);
+    body = con._written.substr(end + 4);
+  }
+
+  bool hasHeader(const char * line) {
+    return head.find(std::string("\r\n") + line + "\r\n") != std::string::npos;
+  }
+
+  /** The check that HTTPConnection does before it keeps the connection open */
+  bool keepsAlive() {
+    return response->isResponseBuffered() || response->isResponseChunked() || response->isResponseLengthDelimited();
+  }
+
+  StubConnection con;
+  HTTPResponse * response;
+  std::string head;
+  std::string body;
+};
+
+static const std::string LARGE_BODY(3 * CACHE_SIZE, 'x');
+
+static void testBuffered() {
+  TestResponse t;
+  t.write("hello");
+  CHECK(t.keepsAlive());
+  t.finalize();
+  CHECK(t.hasHeader("Content-Length: 5"));
+  CHECK(!t.hasHeader("Transfer-Encoding: chunked"));
+  CHECK_EQ(t.body, "hello");
+}
+
+static void testChunked() {
+  TestResponse t;
+  t.write(LARGE_BODY.substr(0, 10));
+  t.write(LARGE_BODY.substr(10));
+  CHECK(t.response->isResponseChunked());
+  CHECK(t.keepsAlive());
+  t.finalize();
+  CHECK(t.hasHeader("Transfer-Encoding: chunked"));
+  CHECK(!t.hasHeader("Content-Length: 48"));
+  CHECK_EQ(t.body, "a\r\n" + LARGE_BODY.substr(0, 10) + "\r\n26\r\n" + LARGE_BODY.substr(10) + "\r\n0\r\n\r\n");
+}
+
+static void testContentLength() {
+  // The body is larger than the cache, but the handler has announced its length
+  TestResponse t;
+  t.response->setHeader("Content-Length", "48");
+  t.write(LARGE_BODY.substr(0, 10));
+  t.write(LARGE_BODY.substr(10));
+  CHECK(!t.response->isResponseBuffered());
+  CHECK(!t.response->isResponseChunked());
+  CHECK(t.keepsAlive());
+  t.finalize();
+  CHECK(t.hasHeader("Content-Length: 48"));
+  CHECK(t.hasHeader("Connection: keep-alive"));
+  CHECK(t.head.find("Transfer-Encoding") == std::string::npos);
+  CHECK_EQ(t.body, LARGE_BODY);
+
+  // Without chunked transfer encoding, the length works as well
+  TestResponse u(false);
+  u.response->setHeader("Content-Length", "48");
+  u.write(LARGE_BODY);
+  CHECK(u.keepsAlive());
+  u.finalize();
+  CHECK(u.hasHeader("Content-Length: 48"));
+  CHECK_EQ(u.body, LARGE_BODY);
+}
+
+static void testWrongContentLength() {
+  // If the body does not match the announced length, the connection has to be closed
+  TestResponse shorter;
+  shorter.response->setHeader("Content-Length", "100");
+  shorter.write(LARGE_BODY);
+  CHECK(!shorter.keepsAlive());
+  shorter.finalize();
+  CHECK(shorter.head.find("Transfer-Encoding") == std::string::npos);
+
+  TestResponse longer;
+  longer.response->setHeader("Content-Length", "20");
+  longer.write(LARGE_BODY);
+  CHECK(!longer.keepsAlive());
+
+  TestResponse invalid;
+  invalid.response->setHeader("Content-Length", "many");
+  invalid.write(LARGE_BODY);
+  CHECK(!invalid.keepsAlive());
+  invalid.finalize();
+  CHECK(invalid.hasHeader("Connection: close"));
+  CHECK(invalid.head.find("Transfer-Encoding") == std::string::npos);
+}
+
+static void testNoChunkedEncoding() {
+  // An HTTP/1.0 client gets the body until the connection is closed
+  TestResponse t(false);
+  t.write(LARGE_BODY);
+  CHECK(!t.keepsAlive());
+  t.finalize();
+  CHECK(t.hasHeader("Connection: close"));
+  CHECK(t.head.find("Transfer-Encoding") == std::string::npos);
+  CHECK_EQ(t.body, LARGE_BODY);
+}
+
+int main() {
+  testBuffered();
+  testChunked();
+  testContentLength();
+  testWrongContentLength();
+  testNoChunkedEncoding();
+  return checkResult();
+}
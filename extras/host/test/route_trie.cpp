@@ -0,0 +1,235 @@
+/**
+ * Test: Matching request paths with RouteTrie
+ *
+ * Registers nodes whose paths share prefixes, so that trie nodes are split
+ * while they are inserted, and checks which node a path resolves to: static
+ * parts before typed parameters before untyped ones, backtracking into a
+ * parameter if the static branch does not lead to a node, the order of
+ * registration for equal paths, the values of the URL parameters, their
+ * types and the methods that are collected for 405 responses.
+ *
+ * Usage: test_route_trie
+ */
+
+#include <string>
+#include <vector>
+
+#include <RouteTrie.hpp>
+#include <ResourceNode.hpp>
+#include <WebsocketNode.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+void handleNothing(HTTPRequest *, HTTPResponse *) {
+}
+
+/** Trie that owns its nodes */
+struct TestTrie {
+  ~TestTrie() {
+    for(size_t i = 0; i < nodes.size(); i++) {
+      delete nodes[i];
+    }
+  }
+
+  HTTPNode * add(const char * path, HTTPMethodMask methods) {
+    HTTPNode * node = new ResourceNode(path, methods, &handleNothing);
+    nodes.push_back(node);
+    trie.insert(node);
+    return node;
+  }
+
+  HTTPNode * add(const char * path, const char * method) {
+    HTTPNode * node = new ResourceNode(path, method, &handleNothing);
+    nodes.push_back(node);
+    trie.insert(node);
+    return node;
+  }
+
+  HTTPNode * match(const char * path, HTTPMethodId methodId = METHOD_GET, HTTPNodeType nodeType = HANDLER_CALLBACK) {
+    params.resetUrlParameters();
+    return trie.match(methodId, HTTPSpan(getMethodName(methodId)), HTTPSpan(path), nodeType, &params);
+  }
+
+  std::string param(uint8_t idx) {
+    return params.getUrlParameter(idx);
+  }
+
+  RouteTrie trie;
+  std::vector<HTTPNode*> nodes;
+  ResourceParameters params;
+};
+
+static void testSplits() {
+  // Each path diverges from the previous ones within an existing trie node
+  TestTrie t;
+  HTTPNode * apple = t.add("/apple", METHOD_GET);
+  HTTPNode * apply = t.add("/apply", METHOD_GET);
+  HTTPNode * app = t.add("/app", METHOD_GET);
+  HTTPNode * root = t.add("/", METHOD_GET);
+  HTTPNode * apricot = t.add("/apricot", METHOD_GET);
+  HTTPNode * banana = t.add("/banana", METHOD_GET);
+
+  CHECK(t.match("/apple") == apple);
+  CHECK(t.match("/apply") == apply);
+  CHECK(t.match("/app") == app);
+  CHECK(t.match("/") == root);
+  CHECK(t.match("/apricot") == apricot);
+  CHECK(t.match("/banana") == banana);
+
+  // Prefixes and extensions of registered paths don't match
+  CHECK(t.match("") == NULL);
+  CHECK(t.match("/ap") == NULL);
+  CHECK(t.match("/appl") == NULL);
+  CHECK(t.match("/apples") == NULL);
+  CHECK(t.match("/b") == NULL);
+  CHECK(t.match("/Apple") == NULL);
+}
+
+static void testPrecedence() {
+  // Registered in the reverse order of their precedence
+  TestTrie t;
+  HTTPNode * any = t.add("/item/*", METHOD_GET);
+  HTTPNode * typed = t.add("/item/*{int}", METHOD_GET);
+  HTTPNode * fixed = t.add("/item/new", METHOD_GET);
+
+  CHECK(t.match("/item/new") == fixed);
+  CHECK(t.match("/item/42") == typed);
+  CHECK_EQ(t.param(0), "42");
+  CHECK(t.match("/item/-7") == typed);
+  CHECK(t.match("/item/abc") == any);
+  CHECK_EQ(t.param(0), "abc");
+  CHECK(t.match("/item/newer") == any);
+  CHECK_EQ(t.param(0), "newer");
+  // An empty value is a value as well
+  CHECK(t.match("/item/") == any);
+  CHECK_EQ(t.param(0), "");
+}
+
+static void testBacktracking() {
+  // The static branch matches the beginning of the path, but has no node for the rest of it
+  TestTrie t;
+  HTTPNode * fixed = t.add("/a/b/d", METHOD_GET);
+  HTTPNode * param = t.add("/a/*/c", METHOD_GET);
+
+  CHECK(t.match("/a/b/d") == fixed);
+  CHECK(t.match("/a/b/c") == param);
+  CHECK_EQ(t.param(0), "b");
+  CHECK(t.match("/a/x/c") == param);
+  CHECK_EQ(t.param(0), "x");
+  CHECK(t.match("/a/b/e") == NULL);
+
+  // A typed parameter that rejects the value falls back to the untyped one
+  TestTrie u;
+  HTTPNode * typed = u.add("/user/*{uint}/name", METHOD_GET);
+  HTTPNode * untyped = u.add("/user/*/name", METHOD_GET);
+  CHECK(u.match("/user/12/name") == typed);
+  CHECK(u.match("/user/bob/name") == untyped);
+  CHECK_EQ(u.param(0), "bob");
+}
+
+static void testParameters() {
+  TestTrie t;
+  HTTPNode * two = t.add("/device/*/sensor/*", METHOD_GET);
+  HTTPNode * file = t.add("/files/*.txt", METHOD_GET);
+  HTTPNode * last = t.add("/rest/*", METHOD_GET);
+
+  CHECK(t.match("/device/kitchen/sensor/3") == two);
+  CHECK_EQ(t.param(0), "kitchen");
+  CHECK_EQ(t.param(1), "3");
+
+  // The parameter ends at the first occurrence of the character that follows it
+  CHECK(t.match("/files/notes.txt") == file);
+  CHECK_EQ(t.param(0), "notes");
+  CHECK(t.match("/files/notes.md") == NULL);
+
+  // A parameter at the end takes the rest of the path, including slashes
+  CHECK(t.match("/rest/a/b/c") == last);
+  CHECK_EQ(t.param(0), "a/b/c");
+
+  // A '*' that does not follow a slash is a literal character
+  TestTrie u;
+  HTTPNode * star = u.add("/a*b", METHOD_GET);
+  CHECK(u.match("/a*b") == star);
+  CHECK(u.match("/axb") == NULL);
+}
+
+static void testTypes() {
+  TestTrie t;
+  HTTPNode * mode = t.add("/mode/*{on|off}", METHOD_GET);
+  HTTPNode * id = t.add("/id/*{uuid}", METHOD_GET);
+  HTTPNode * hex = t.add("/hex/*{hex}", METHOD_GET);
+  // Braces without a type name or '|' are no type, but text that follows the parameter
+  HTTPNode * unknown = t.add("/x/*{foo}", METHOD_GET);
+  HTTPNode * empty = t.add("/e/*{}", METHOD_GET);
+
+  CHECK(t.match("/mode/on") == mode);
+  CHECK(t.match("/mode/off") == mode);
+  CHECK(t.match("/mode/of") == NULL);
+  CHECK(t.match("/mode/on|off") == NULL);
+  CHECK(t.match("/id/01234567-89ab-cdef-0123-456789ABCDEF") == id);
+  CHECK(t.match("/id/01234567-89ab-cdef-0123") == NULL);
+  CHECK(t.match("/hex/00fF") == hex);
+  CHECK(t.match("/hex/0x1") == NULL);
+  // Control characters that become digits when they are lowercased
+  CHECK(t.match("/hex/\x10\x19") == NULL);
+  CHECK(t.match("/id/\x10\x11\x12\x13\x14\x15\x16\x17-89ab-cdef-0123-456789ABCDEF") == NULL);
+
+  CHECK(t.match("/x/a{foo}") == unknown);
+  CHECK_EQ(t.param(0), "a");
+  CHECK(t.match("/x/foo") == NULL);
+  CHECK(t.match("/e/a{}") == empty);
+  CHECK_EQ(t.param(0), "a");
+}
+
+static void testMethods() {
+  TestTrie t;
+  HTTPNode * get = t.add("/res", METHOD_GET);
+  HTTPNode * first = t.add("/res", METHOD_POST | METHOD_PUT);
+  HTTPNode * second = t.add("/res", METHOD_POST);
+  HTTPNode * custom = t.add("/res", "PROPFIND");
+
+  CHECK(t.match("/res", METHOD_GET) == get);
+  // Nodes with the same path are tried in the order of registration
+  CHECK(t.match("/res", METHOD_POST) == first);
+  CHECK(second != NULL);
+  CHECK(t.match("/res", METHOD_PUT) == first);
+
+  // Methods that the server does not know are compared by their name
+  t.params.resetUrlParameters();
+  CHECK(t.trie.match(METHOD_UNKNOWN, HTTPSpan("PROPFIND"), HTTPSpan("/res"), HANDLER_CALLBACK, &t.params) == custom);
+  CHECK(t.trie.match(METHOD_UNKNOWN, HTTPSpan("MKCOL"), HTTPSpan("/res"), HANDLER_CALLBACK, &t.params) == NULL);
+
+  // The methods of the nodes for the path are collected if none accepts the request
+  HTTPMethodMask allowed = 0;
+  CHECK(t.trie.match(METHOD_DELETE, HTTPSpan("DELETE"), HTTPSpan("/res"), HANDLER_CALLBACK, &t.params, &allowed) == NULL);
+  CHECK_EQ(allowed, (HTTPMethodMask)(METHOD_GET | METHOD_POST | METHOD_PUT));
+
+  // Nothing is collected for a path that does not exist
+  allowed = 0;
+  CHECK(t.trie.match(METHOD_DELETE, HTTPSpan("DELETE"), HTTPSpan("/other"), HANDLER_CALLBACK, &t.params, &allowed) == NULL);
+  CHECK_EQ(allowed, 0);
+}
+
+static void testNodeTypes() {
+  TestTrie t;
+  HTTPNode * handler = t.add("/ws", METHOD_GET);
+  HTTPNode * websocket = new WebsocketNode("/ws", NULL);
+  t.nodes.push_back(websocket);
+  t.trie.insert(websocket);
+
+  CHECK(t.match("/ws", METHOD_GET, HANDLER_CALLBACK) == handler);
+  CHECK(t.match("/ws", METHOD_GET, WEBSOCKET) == websocket);
+}
+
+int main() {
+  testSplits();
+  testPrecedence();
+  testBacktracking();
+  testParameters();
+  testTypes();
+  testMethods();
+  testNodeTypes();
+  return checkResult();
+}
@@ -0,0 +1,232 @@
+/**
+ * Test: Resolving request paths with a compile-time StaticRouteTable
+ *
+ * Declares the routes as a constexpr table, so the analysis of their paths is
+ * checked by the compiler, and resolves requests through ResourceResolver:
+ * static text and typed URL parameters, the order of the table, the methods
+ * that are collected for 405 responses, HEAD requests that are answered by a
+ * GET route, and the precedence of static routes over registered nodes.
+ *
+ * Usage: test_static_routes
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ResourceResolver.hpp>
+#include <StaticRouteTable.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+void handleNothing(HTTPRequest *, HTTPResponse *) {
+}
+
+void handleOther(HTTPRequest *, HTTPResponse *) {
+}
+
+constexpr StaticRoute ROUTES[] = {
+  StaticRoute("/", METHOD_GET, &handleNothing, "root"),
+  StaticRoute("/led/*{uint}/*{on|off}", METHOD_POST | METHOD_PUT, &handleNothing, "led"),
+  StaticRoute("/led/all", METHOD_POST, &handleNothing, "all"),
+  StaticRoute("/file/*.txt", METHOD_GET, &handleNothing, "file"),
+  StaticRoute("/file/*", METHOD_GET, &handleOther, "anyfile"),
+  StaticRoute("/id/*{uuid}", METHOD_DELETE, &handleNothing, "id"),
+  StaticRoute("/status", METHOD_GET, &handleNothing, "status"),
+  StaticRoute("/config", METHOD_GET, &handleNothing, "config"),
+  StaticRoute("/shared/*", METHOD_GET, &handleNothing, "shared")
+};
+
+constexpr StaticRouteTable ROUTE_TABLE(ROUTES);
+
+// The paths are analyzed by the compiler
+static_assert(ROUTE_TABLE.getCount() == 9, "Number of routes");
+static_assert(ROUTES[0]._paramCount == 0 && ROUTES[0]._staticLength == 1, "Route without parameters");
+static_assert(ROUTES[1]._paramCount == 2 && ROUTES[1]._staticLength == 5, "Route with two parameters");
+static_assert(ROUTES[1]._params[0].start == 5 && ROUTES[1]._params[0].end == 12, "Position of a typed parameter");
+static_assert(ROUTES[1]._params[0].constraint.getType() == URLParamConstraint::PARAM_UINT, "Type of a parameter");
+static_assert(ROUTES[1]._params[1].constraint.getType() == URLParamConstraint::PARAM_ENUM, "Value list of a parameter");
+static_assert(ROUTES[3]._params[0].end == 7 && ROUTES[3]._params[0].constraint.getType() == URLParamConstraint::PARAM_ANY,
+  "Untyped parameter");
+
+/** Resolver with the table and nodes that it owns */
+struct TestResolver {
+  TestResolver() {
+    resolver.setStaticRoutes(&ROUTE_TABLE);
+  }
+
+  ~TestResolver() {
+    for(size_t i = 0; i < nodes.size(); i++) {
+      delete nodes[i];
+    }
+  }
+
+  HTTPNode * add(const char * path, const char * method) {
+    HTTPNode * node = new ResourceNode(path, method, &handleNothing);
+    nodes.push_back(node);
+    resolver.registerNode(node);
+    return node;
+  }
+
+  /** Resolves the request and returns the tag of the static route or node, or "" */
+  std::string resolve(const char * method, const char * url) {
+    _url = url;
+    resolved.reset(new ResolvedResource());
+    resolver.resolveNode(method, _url, *resolved, HANDLER_CALLBACK);
+    if (resolved->getStaticRoute() != NULL) {
+      return resolved->getStaticRoute()->_tag;
+    }
+    if (resolved->getMatchingNode() != NULL) {
+      return "node:" + resolved->getMatchingNode()->_path;
+    }
+    return "";
+  }
+
+  std::string param(uint8_t idx) {
+    return resolved->getParams()->getUrlParameter(idx);
+  }
+
+  HTTPMethodMask allowed() {
+    return resolved->getAllowedMethods();
+  }
+
+  ResourceResolver resolver;
+  std::vector<HTTPNode*> nodes;
+  std::unique_ptr<ResolvedResource> resolved;
+  std::string _url;
+};
+
+static void testPaths() {
+  TestResolver t;
+  CHECK_EQ(t.resolve("GET", "/"), "root");
+  CHECK_EQ(t.resolve("GET", "/status"), "status");
+  CHECK_EQ(t.resolve("GET", "/status?verbose=1"), "status");
+  CHECK_EQ(t.resolve("GET", "/stat"), "");
+  CHECK_EQ(t.resolve("GET", "/statuses"), "");
+  CHECK_EQ(t.resolve("GET", ""), "");
+
+  CHECK_EQ(t.resolve("POST", "/led/3/on"), "led");
+  CHECK_EQ(t.param(0), "3");
+  CHECK_EQ(t.param(1), "on");
+  CHECK_EQ(t.resolve("PUT", "/led/12/off"), "led");
+  CHECK_EQ(t.param(0), "12");
+  CHECK_EQ(t.param(1), "off");
+
+  // The parameter ends at the first occurrence of the character that follows it
+  CHECK_EQ(t.resolve("GET", "/file/notes.txt"), "file");
+  CHECK_EQ(t.param(0), "notes");
+  // A parameter at the end takes the rest of the path
+  CHECK_EQ(t.resolve("GET", "/file/notes.md"), "anyfile");
+  CHECK_EQ(t.param(0), "notes.md");
+  CHECK_EQ(t.resolve("GET", "/file/a/b.txt"), "file");
+  CHECK_EQ(t.param(0), "a/b");
+}
+
+static void testTypes() {
+  TestResolver t;
+  // Values that don't match the type of a parameter don't match the route
+  CHECK_EQ(t.resolve("POST", "/led/-1/on"), "");
+  CHECK_EQ(t.resolve("POST", "/led/x/on"), "");
+  CHECK_EQ(t.resolve("POST", "/led/1/dim"), "");
+  CHECK_EQ(t.resolve("POST", "/led/1/"), "");
+  CHECK_EQ(t.resolve("DELETE", "/id/01234567-89ab-cdef-0123-456789ABCDEF"), "id");
+  CHECK_EQ(t.resolve("DELETE", "/id/01234567-89ab-cdef-0123-456789ABCDEG"), "");
+  CHECK_EQ(t.resolve("DELETE", "/id/\x10\x11\x12\x13\x14\x15\x16\x17-89ab-cdef-0123-456789ABCDEF"), "");
+}
+
+static void testOrder() {
+  TestResolver t;
+  // The routes are tried in the order of the table, so the parameter comes before the static path
+  // that follows it in the table. "all" is no uint, so the second route handles it.
+  CHECK_EQ(t.resolve("POST", "/led/all"), "all");
+  CHECK_EQ(t.resolve("POST", "/led/7/on"), "led");
+  // "/file/*.txt" comes before "/file/*"
+  CHECK_EQ(t.resolve("GET", "/file/x.txt"), "file");
+}
+
+static void testMethods() {
+  TestResolver t;
+  // A path that exists with other methods is answered with 405, the default node is not used
+  HTTPNode * notFound = new ResourceNode("", "GET", &handleNothing);
+  t.nodes.push_back(notFound);
+  t.resolver.setDefaultNode(notFound);
+
+  CHECK_EQ(t.resolve("GET", "/led/1/on"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)(METHOD_POST | METHOD_PUT));
+  // Only routes that match the path add their methods, "all" is no uint
+  CHECK_EQ(t.resolve("PUT", "/led/all"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)METHOD_POST);
+  // GET allows HEAD as well
+  CHECK_EQ(t.resolve("POST", "/status"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)(METHOD_GET | METHOD_HEAD));
+  // Methods that the server does not know never match a static route
+  CHECK_EQ(t.resolve("PROPFIND", "/status"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)(METHOD_GET | METHOD_HEAD));
+
+  // Paths that don't exist go to the default node
+  CHECK_EQ(t.resolve("GET", "/missing"), "node:");
+  CHECK_EQ(t.allowed(), 0);
+}
+
+static void testHead() {
+  TestResolver t;
+  // A HEAD request is answered by the GET route, with its URL parameters
+  CHECK_EQ(t.resolve("HEAD", "/status"), "status");
+  CHECK_EQ(t.resolve("HEAD", "/file/notes.txt"), "file");
+  CHECK_EQ(t.param(0), "notes");
+  CHECK_EQ(t.resolve("HEAD", "/led/1/on"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)(METHOD_POST | METHOD_PUT));
+
+  // A node for HEAD is preferred over the GET route
+  t.add("/status", "HEAD");
+  CHECK_EQ(t.resolve("HEAD", "/status"), "node:/status");
+}
+
+static void testPrecedenceOverNodes() {
+  TestResolver t;
+  // Static routes are checked before the nodes, even if a node has a more specific path
+  t.add("/shared/special", "GET");
+  t.add("/status", "GET");
+  CHECK_EQ(t.resolve("GET", "/shared/special"), "shared");
+  CHECK_EQ(t.param(0), "special");
+  CHECK_EQ(t.resolve("GET", "/status"), "status");
+
+  // A node is used if no static route accepts the method
+  t.add("/config", "POST");
+  CHECK_EQ(t.resolve("POST", "/config"), "node:/config");
+  // Paths that only nodes have are resolved as usual
+  t.add("/only/*", "GET");
+  CHECK_EQ(t.resolve("GET", "/only/node"), "node:/only/*");
+  CHECK_EQ(t.param(0), "node");
+
+  // The methods of routes and nodes for the path are combined for 405
+  CHECK_EQ(t.resolve("DELETE", "/config"), "");
+  CHECK_EQ(t.allowed(), (HTTPMethodMask)(METHOD_GET | METHOD_HEAD | METHOD_POST));
+}
+
+static void testRuntimeTable() {
+  // Routes can also be created at runtime, e.g. to test them. The parameters beyond the limit are
+  // treated as literal text then.
+  const StaticRoute routes[] = {
+    StaticRoute("/a/*/*/*/*/*", METHOD_GET, &handleNothing, "five")
+  };
+  StaticRouteTable table(routes);
+  CHECK_EQ(routes[0]._paramCount, HTTPS_STATIC_ROUTE_MAX_PARAMS);
+  ResourceParameters params;
+  CHECK(table.match(METHOD_GET, HTTPSpan("/a/1/2/3/4/*"), &params) == &routes[0]);
+  CHECK_EQ(params.getUrlParameter(3), "4");
+  CHECK(table.match(METHOD_GET, HTTPSpan("/a/1/2/3/4/5"), &params) == NULL);
+}
+
+int main() {
+  testPaths();
+  testTypes();
+  testOrder();
+  testMethods();
+  testHead();
+  testPrecedenceOverNodes();
+  testRuntimeTable();
+  return checkResult();
+}
@@ -0,0 +1,165 @@
+/**
+ * Test: TimerWheel
+ *
+ * Runs timers with delays on all levels of the wheel (and beyond its range),
+ * advancing the time in steps of 1 ms, and checks that each timer fires once
+ * and within HTTPS_TIMER_RESOLUTION after its delay. This is repeated across
+ * the wrap-around of millis(). Cancelling, rescheduling and callbacks that
+ * change other timers are checked as well.
+ *
+ * Usage: test_timer_wheel
+ */
+
+#include <vector>
+
+#include <TimerWheel.hpp>
+
+#include "check.hpp"
+
+using namespace httpsserver;
+
+// Delays around the boundaries of the levels (0.32 s, 10.24 s, 327.68 s with the defaults)
+static const unsigned long DELAYS[] = {
+  0, 1, 9, 10, 11, 150, 309, 310, 319, 320, 321, 5000, 10229, 10230, 10239, 10240, 10241,
+  20000, 327670, 327680, 327690, 400000, 700000
+};
+#define DELAY_COUNT (sizeof(DELAYS) / sizeof(DELAYS[0]))
+
+/** Schedules one timer for each of DELAYS at start and checks when they fire */
+static void checkDelays(uint32_t start) {
+  TimerWheel wheel(start);
+  uint32_t now = start;
+  std::vector<Timer*> timers;
+  // Time (relative to start) at which each timer has fired, and how often
+  std::vector<uint32_t> firedAt(DELAY_COUNT, 0);
+  std::vector<int> fireCount(DELAY_COUNT, 0);
+
+  for(size_t i = 0; i < DELAY_COUNT; i++) {
+    Timer * timer = new Timer([&firedAt, &fireCount, &now, start, i]() {
+      firedAt[i] = now - start;
+      fireCount[i]++;
+    });
+    wheel.schedule(timer, DELAYS[i]);
+    timers.push_back(timer);
+  }
+
+  uint32_t end = DELAYS[DELAY_COUNT - 1] + 10 * HTTPS_TIMER_RESOLUTION;
+  for(uint32_t t = 1; t <= end; t++) {
+    now = start + t;
+    wheel.update(now);
+  }
+
+  for(size_t i = 0; i < DELAY_COUNT; i++) {
+    if (fireCount[i] != 1 || firedAt[i] < DELAYS[i] || firedAt[i] > DELAYS[i] + HTTPS_TIMER_RESOLUTION) {
+      fprintf(stderr, "start %u: timer with delay %lu fired %d time(s), last at %u\n",
+        (unsigned)start, DELAYS[i], fireCount[i], (unsigned)firedAt[i]);
+    }
+    CHECK_EQ(fireCount[i], 1);
+    CHECK(firedAt[i] >= DELAYS[i]);
+    CHECK(firedAt[i] <= DELAYS[i] + HTTPS_TIMER_RESOLUTION);
+    CHECK(!timers[i]->isScheduled());
+    delete timers[i];
+  }
+}
+
+static void testDelays() {
+  checkDelays(0);
+  checkDelays(123457);
+}
+
+static void testWrapAround() {
+  // millis() wraps while the timers are pending, on each level
+  checkDelays(0xffffffffu - 5);
+  checkDelays(0xffffffffu - 5000);
+  checkDelays(0xffffffffu - 300000);
+}
+
+static void testLargeStep() {
+  // A loop that has been blocked for a while runs all timers that have expired in the meantime
+  TimerWheel wheel(1000);
+  int fired = 0;
+  Timer a([&fired]() { fired++; });
+  Timer b([&fired]() { fired++; });
+  Timer c([&fired]() { fired++; });
+  wheel.schedule(&a, 100);
+  wheel.schedule(&b, 20000);
+  wheel.schedule(&c, 500000);
+  wheel.update(1000 + 30000);
+  CHECK_EQ(fired, 2);
+  CHECK(c.isScheduled());
+  wheel.update(1000 + 600000);
+  CHECK_EQ(fired, 3);
+
+  // Skipping ahead with an empty wheel must not break timers that are scheduled afterwards
+  wheel.update(1000 + 5000000);
+  wheel.schedule(&a, 50);
+  wheel.update(1000 + 5000000 + 40);
+  CHECK_EQ(fired, 3);
+  wheel.update(1000 + 5000000 + 60);
+  CHECK_EQ(fired, 4);
+}
+
+static void testCancelAndReschedule() {
+  TimerWheel wheel(0);
+  int firedA = 0;
+  int firedB = 0;
+  Timer a([&firedA]() { firedA++; });
+  Timer b([&firedB]() { firedB++; });
+
+  wheel.schedule(&a, 100);
+  CHECK(a.isScheduled());
+  a.cancel();
+  CHECK(!a.isScheduled());
+  // Cancelling twice is harmless
+  a.cancel();
+
+  // Rescheduling moves the timer, like a timeout that is extended by new data
+  wheel.schedule(&b, 100);
+  wheel.update(50);
+  wheel.schedule(&b, 100);
+  wheel.update(120);
+  CHECK_EQ(firedB, 0);
+  wheel.update(170);
+  CHECK_EQ(firedA, 0);
+  CHECK_EQ(firedB, 1);
+
+  // A destroyed timer is removed from the wheel
+  {
+    Timer c([&firedA]() { firedA++; });
+    wheel.schedule(&c, 10);
+  }
+  wheel.update(300);
+  CHECK_EQ(firedA, 0);
+}
+
+static void testCallbacks() {
+  TimerWheel wheel(0);
+  int firedA = 0;
+  int firedB = 0;
+  Timer b([&firedB]() { firedB++; });
+  // a cancels b, which expires in the same tick, and reschedules itself
+  Timer a;
+  a.setCallback([&]() {
+    firedA++;
+    b.cancel();
+    if (firedA < 3) {
+      wheel.schedule(&a, 100);
+    }
+  });
+  wheel.schedule(&b, 100);
+  wheel.schedule(&a, 100);
+  for(unsigned long t = 1; t <= 1000; t++) {
+    wheel.update(t);
+  }
+  CHECK_EQ(firedA, 3);
+  CHECK_EQ(firedB, 0);
+}
+
+int main() {
+  testDelays();
+  testWrapAround();
+  testLargeStep();
+  testCancelAndReschedule();
+  testCallbacks();
+  return checkResult();
+}
@@ -7,6 +7,8 @@
 #include "openssl/ssl.h"
 #undef read
 
+#include "RequestArena.hpp"
+
 namespace httpsserver {
 
 class WebsocketHandler;
@@ -20,13 +22,20 @@ public:
   virtual ~ConnectionContext();
 
   virtual void signalRequestError() = 0;
+  virtual void signalClientError() = 0;
   virtual void signalClientClose() = 0;
   virtual size_t getCacheSize() = 0;
+  virtual bool canSendChunked() = 0;
+  virtual RequestArena * getArena() = 0;
 
   virtual size_t readBuffer(byte* buffer, size_t length) = 0;
+  virtual size_t peekBuffer(byte** data) = 0;
+  virtual void consumeBuffer(size_t length) = 0;
   virtual size_t pendingBufferSize() = 0;
+  virtual bool isInputClosed() = 0;
 
   virtual size_t writeBuffer(byte* buffer, size_t length) = 0;
+  virtual void flushBuffer() = 0;
 
   virtual bool isSecure() = 0;
   virtual void setWebsocketHandler(WebsocketHandler *wsHandler);
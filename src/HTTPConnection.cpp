@@ -2,27 +2,92 @@
 
 namespace httpsserver {
 
-HTTPConnection::HTTPConnection(ResourceResolver * resResolver):
+HTTPConnection::HTTPConnection(ResourceResolver * resResolver, TimerWheel * timerWheel):
+  _timerWheel(timerWheel),
   _resResolver(resResolver) {
   _socket = -1;
   _addrLen = 0;
 
   _bufferProcessed = 0;
   _bufferUnusedIdx = 0;
+  _headBuffer = NULL;
+  _headCapacity = 0;
+  _headLength = 0;
+  _lineStart = 0;
+  _sendBufferLength = 0;
+  _responseCount = 0;
+  _socketWriteCount = 0;
 
   _connectionState = STATE_UNDEFINED;
   _clientState = CSTATE_UNDEFINED;
-  _httpHeaders = NULL;
+  _readiness = READINESS_UNKNOWN;
+  // Allocated once, so that a recycled connection can reuse the storage
+  _httpHeaders = new HTTPHeaders(&_arena);
   _defaultHeaders = NULL;
   _isKeepAlive = false;
-  _lastTransmissionTS = millis();
-  _shutdownTS = 0;
+  _httpMethodId = METHOD_UNKNOWN;
+  _isHTTP11 = false;
+  _headerTimeoutSet = false;
+  _isDraining = false;
   _wsHandler = nullptr;
+  _timeoutTimer.setCallback([this]() { handleTimeout(); });
 }
 
 HTTPConnection::~HTTPConnection() {
   // Close the socket
   closeConnection();
+
+  delete _httpHeaders;
+  delete[] _headBuffer;
+}
+
+/**
+ * Prepares a closed connection object to be used for the next client.
+ *
+ * The server keeps a pool of connection objects and calls this before it puts a connection
+ * back on its free list. Resources that are still held (e.g. after an error) are released.
+ */
+void HTTPConnection::reset() {
+  closeConnection();
+
+  _bufferProcessed = 0;
+  _bufferUnusedIdx = 0;
+  // Idle connections in the pool don't keep the head buffer
+  delete[] _headBuffer;
+  _headBuffer = NULL;
+  _headCapacity = 0;
+  _headLength = 0;
+  _lineStart = 0;
+  _sendBufferLength = 0;
+
+  _connectionState = STATE_UNDEFINED;
+  _clientState = CSTATE_UNDEFINED;
+  _readiness = READINESS_UNKNOWN;
+  _defaultHeaders = NULL;
+  _isKeepAlive = false;
+  _isHTTP11 = false;
+  _headerTimeoutSet = false;
+  _isDraining = false;
+  _timeoutTimer.cancel();
+  _httpHeaders->clearAll();
+  // Like the head buffer, the arena's buffer is not kept by idle connections
+  _arena.release();
+}
+
+/**
+ * Lets the connection finish the request that is currently processed, but closes it afterwards
+ * instead of keeping it alive. Connections that wait for a request are closed right away, websocket
+ * connections are asked to close.
+ */
+void HTTPConnection::drain() {
+  _isDraining = true;
+  if (_connectionState == STATE_HANDSHAKE ||
+      (_connectionState == STATE_INITIAL && _headLength == 0 && _bufferProcessed == _bufferUnusedIdx)) {
+    HTTPS_LOGD("Closing idle connection for shutdown. FID=%d", _socket);
+    closeConnection();
+  } else if (_connectionState == STATE_WEBSOCKET && _wsHandler != nullptr && !_wsHandler->closed()) {
+    _wsHandler->close(WebsocketHandler::CLOSE_GOING_AWAY);
+  }
 }
 
 /**
@@ -39,8 +104,7 @@ int HTTPConnection::initialize(int serverSocketID, HTTPHeaders *defaultHeaders)
     if (_socket >= 0) {
       HTTPS_LOGI("New connection. Socket FID=%d", _socket);
       _connectionState = STATE_INITIAL;
-      _httpHeaders = new HTTPHeaders();
-      refreshTimeout();
+      setTimeout(HTTPS_CONNECTION_TIMEOUT);
       return _socket;
 
     }
@@ -60,19 +124,36 @@ int HTTPConnection::initialize(int serverSocketID, HTTPHeaders *defaultHeaders)
 
 
 /**
- * True if the connection is timed out.
- *
- * (Should be checkd in the loop and transition should go to CONNECTION_CLOSE if exceeded)
+ * (Re-)starts the timeout of the connection. When it expires, handleTimeout() is called.
  */
-bool HTTPConnection::isTimeoutExceeded() {
-  return _lastTransmissionTS + HTTPS_CONNECTION_TIMEOUT < millis();
+void HTTPConnection::setTimeout(unsigned long timeout) {
+  _timerWheel->schedule(&_timeoutTimer, timeout);
 }
 
 /**
- * Resets the timeout to allow again the full HTTPS_CONNECTION_TIMEOUT milliseconds
+ * Updates the timeout after data has been received.
+ *
+ * While the request head is read, the first call starts the HTTPS_HEADER_TIMEOUT, which is not
+ * extended by further data. Otherwise, the connection gets the full HTTPS_CONNECTION_TIMEOUT again.
+ * Websocket connections don't time out.
  */
 void HTTPConnection::refreshTimeout() {
-  _lastTransmissionTS = millis();
+  if (_connectionState == STATE_INITIAL || _connectionState == STATE_REQUEST_FINISHED) {
+    if (!_headerTimeoutSet) {
+      _headerTimeoutSet = true;
+      setTimeout(HTTPS_HEADER_TIMEOUT);
+    }
+  } else if (_connectionState != STATE_WEBSOCKET) {
+    setTimeout(HTTPS_CONNECTION_TIMEOUT);
+  }
+}
+
+/**
+ * Called by the timer wheel if the connection has timed out
+ */
+void HTTPConnection::handleTimeout() {
+  HTTPS_LOGI("Connection timeout. FID=%d", _socket);
+  closeConnection();
 }
 
 /**
@@ -93,14 +174,38 @@ bool HTTPConnection::isSecure() {
   return false;
 }
 
+/**
+ * Returns the socket FID of this connection, or -1 if there is no open socket.
+ */
+int HTTPConnection::getSocket() {
+  return _socket;
+}
+
+/**
+ * Passes the result of a readiness check on the socket to the connection, so that the next
+ * call to canReadData() does not need to check the socket again.
+ *
+ * The server uses this to check all of its sockets with a single select() call per loop.
+ * The information is only valid until the next read from the socket, the next request handler
+ * call, or the end of the current loop().
+ */
+void HTTPConnection::setReadiness(bool socketReadable) {
+  _readiness = socketReadable ? READINESS_READABLE : READINESS_IDLE;
+}
+
 void HTTPConnection::closeConnection() {
   // TODO: Call an event handler here, maybe?
 
+  // Send what is left in the buffer before the socket is closed
+  if (_socket >= 0) {
+    flushBuffer();
+  }
+
   if (_connectionState != STATE_ERROR && _connectionState != STATE_CLOSED) {
 
-    // First call to closeConnection - set the timestamp to calculate the timeout later on
+    // First call to closeConnection - start the shutdown timeout
     if (_connectionState != STATE_CLOSING) {
-      _shutdownTS = millis();
+      setTimeout(HTTPS_SHUTDOWN_TIMEOUT);
     }
 
     // Set the connection state to closing. We stay in closing as long as SSL has not been shutdown
@@ -120,15 +225,14 @@ void HTTPConnection::closeConnection() {
     _connectionState = STATE_CLOSED;
   }
 
-  if (_httpHeaders != NULL) {
-    HTTPS_LOGD("Free headers");
-    delete _httpHeaders;
-    _httpHeaders = NULL;
-  }
+  _timeoutTimer.cancel();
+
+  _httpHeaders->clearAll();
 
   if (_wsHandler != nullptr) {
     HTTPS_LOGD("Free WS Handler");
     delete _wsHandler;
+    _wsHandler = nullptr;
   }
 }
 
@@ -138,7 +242,14 @@ void HTTPConnection::closeConnection() {
 int HTTPConnection::updateBuffer() {
   if (!isClosed()) {
 
-    // If there is buffer data that has been marked as processed.
+    // If everything in the buffer has been processed, we can start at the beginning again
+    if (_bufferProcessed > 0 && _bufferProcessed == _bufferUnusedIdx) {
+      _bufferProcessed = 0;
+      _bufferUnusedIdx = 0;
+    }
+
+    // If less than half of the buffer is left for new data, move the unprocessed data to the
+    // front. We don't do this on every call, so the same bytes are not moved over and over again.
     // Some example is shown here:
     //
     // Previous configuration:
@@ -148,18 +259,10 @@ int HTTPConnection::updateBuffer() {
     // New configuration after shifting:
     // Host: test\\Foo: bar\\\\[some uninitialized memory]
     // ^ processed             ^ unusedIdx
-    if (_bufferProcessed > 0) {
-      for(int i = 0; i < HTTPS_CONNECTION_DATA_CHUNK_SIZE; i++) {
-        int copyFrom = i + _bufferProcessed;
-        if (copyFrom < _bufferUnusedIdx) {
-          _receiveBuffer[i] = _receiveBuffer[copyFrom];
-        } else {
-          break;
-        }
-      }
+    if (_bufferProcessed > 0 && HTTPS_CONNECTION_DATA_CHUNK_SIZE - _bufferUnusedIdx < HTTPS_CONNECTION_DATA_CHUNK_SIZE / 2) {
+      memmove(_receiveBuffer, _receiveBuffer + _bufferProcessed, _bufferUnusedIdx - _bufferProcessed);
       _bufferUnusedIdx -= _bufferProcessed;
       _bufferProcessed = 0;
-
     }
 
     if (_bufferUnusedIdx < HTTPS_CONNECTION_DATA_CHUNK_SIZE) {
@@ -180,6 +283,9 @@ int HTTPConnection::updateBuffer() {
             HTTPS_CONNECTION_DATA_CHUNK_SIZE - _bufferUnusedIdx
         );
 
+        // After reading, there may or may not be data left on the socket
+        _readiness = READINESS_UNKNOWN;
+
         if (readReturnCode > 0) {
           _bufferUnusedIdx += readReturnCode;
           refreshTimeout();
@@ -207,6 +313,11 @@ int HTTPConnection::updateBuffer() {
 }
 
 bool HTTPConnection::canReadData() {
+  // Use the result of the server's readiness check, if there is one
+  if (_readiness != READINESS_UNKNOWN) {
+    return _readiness == READINESS_READABLE;
+  }
+
   fd_set sockfds;
   FD_ZERO( &sockfds );
   FD_SET(_socket, &sockfds);
@@ -219,27 +330,56 @@ bool HTTPConnection::canReadData() {
   // Check for input
   // As by 2017-12-14, it seems that FD_SETSIZE is defined as 0x40, but socket IDs now
   // start at 0x1000, so we need to use _socket+1 here
-  select(_socket + 1, &sockfds, NULL, NULL, &timeout);
+  // If select() fails (e.g. when it is interrupted), the set is undefined
+  return select(_socket + 1, &sockfds, NULL, NULL, &timeout) > 0 && FD_ISSET(_socket, &sockfds);
+}
 
-  return FD_ISSET(_socket, &sockfds);
+/**
+ * Returns true if no more request data can arrive, because the connection has been closed or
+ * the client has closed its side and everything it has sent has been processed
+ */
+bool HTTPConnection::isInputClosed() {
+  return isClosed() || (_clientState == CSTATE_CLOSED && _bufferProcessed == _bufferUnusedIdx);
 }
 
 size_t HTTPConnection::readBuffer(byte* buffer, size_t length) {
-  updateBuffer();
-  size_t bufferSize = _bufferUnusedIdx - _bufferProcessed;
+  byte * data;
+  size_t bufferSize = peekBuffer(&data);
 
   if (length > bufferSize) {
     length = bufferSize;
   }
 
-  // Write until length is reached (either by param of by empty buffer
-  for(int i = 0; i < length; i++) {
-    buffer[i] = _receiveBuffer[_bufferProcessed++];
-  }
+  // Copy until length is reached (either by param of by empty buffer)
+  memcpy(buffer, data, length);
+  consumeBuffer(length);
 
   return length;
 }
 
+/**
+ * Makes the unprocessed data in the receive buffer available without copying it.
+ *
+ * Sets data to the first unprocessed byte and returns the number of contiguous bytes that
+ * follow. The data remains in the buffer until it is marked as processed by consumeBuffer().
+ */
+size_t HTTPConnection::peekBuffer(byte** data) {
+  updateBuffer();
+  *data = (byte*)(_receiveBuffer + _bufferProcessed);
+  return _bufferUnusedIdx - _bufferProcessed;
+}
+
+/**
+ * Marks length bytes of the receive buffer as processed (see peekBuffer()).
+ */
+void HTTPConnection::consumeBuffer(size_t length) {
+  size_t bufferSize = _bufferUnusedIdx - _bufferProcessed;
+  if (length > bufferSize) {
+    length = bufferSize;
+  }
+  _bufferProcessed += length;
+}
+
 size_t HTTPConnection::pendingBufferSize() {
   updateBuffer();
 
@@ -250,10 +390,56 @@ size_t HTTPConnection::pendingByteCount() {
   return 0; // FIXME: Add the value of the equivalent function of SSL_pending() here
 }
 
+/**
+ * Writes data to the client.
+ *
+ * The data is collected in the send buffer and sent with the next call to flushBuffer(), or when the
+ * buffer is full. Writes that do not fit into the buffer at all are passed to the socket directly.
+ */
 size_t HTTPConnection::writeBuffer(byte* buffer, size_t length) {
+  if (_sendBufferLength + length > HTTPS_CONNECTION_SEND_BUFFER_SIZE) {
+    flushBuffer();
+    if (length >= HTTPS_CONNECTION_SEND_BUFFER_SIZE) {
+      _socketWriteCount++;
+      return sendBytes(buffer, length);
+    }
+  }
+  memcpy(_sendBuffer + _sendBufferLength, buffer, length);
+  _sendBufferLength += length;
+  return length;
+}
+
+/**
+ * Sends the content of the send buffer to the client
+ */
+void HTTPConnection::flushBuffer() {
+  if (_sendBufferLength > 0) {
+    // FIXME: Return value?
+    _socketWriteCount++;
+    sendBytes(_sendBuffer, _sendBufferLength);
+    _sendBufferLength = 0;
+  }
+}
+
+size_t HTTPConnection::sendBytes(byte* buffer, size_t length) {
   return send(_socket, buffer, length, 0);
 }
 
+/**
+ * Returns the number of responses that have been sent on this connection object
+ */
+unsigned long HTTPConnection::getResponseCount() {
+  return _responseCount;
+}
+
+/**
+ * Returns the number of writes to the socket on this connection object. For TLS connections, each
+ * write results in one record (as long as it is not larger than the maximum record size).
+ */
+unsigned long HTTPConnection::getSocketWriteCount() {
+  return _socketWriteCount;
+}
+
 size_t HTTPConnection::readBytesToBuffer(byte* buffer, size_t length) {
   return recv(_socket, buffer, length, MSG_WAITALL | MSG_DONTWAIT);
 }
@@ -275,35 +461,119 @@ void HTTPConnection::clientError() {
   closeConnection();
 }
 
-void HTTPConnection::readLine(int lengthLimit) {
+void HTTPConnection::headerTooLarge() {
+  _connectionState = STATE_ERROR;
+
+  char staticResponse[] = "HTTP/1.1 431 Request Header Fields Too Large\r\nServer: esp32https\r\nConnection:close\r\nContent-Type: text/html\r\nContent-Length:46\r\n\r\n<h1>431 Request Header Fields Too Large</h1>";
+  writeBuffer((byte*)staticResponse, strlen(staticResponse));
+  closeConnection();
+}
+
+/**
+ * Makes sure that the head buffer has room for length bytes, growing it if necessary. Returns false
+ * if that would exceed HTTPS_REQUEST_MAX_HEAD_LENGTH.
+ */
+bool HTTPConnection::reserveHead(size_t length) {
+  if (length <= _headCapacity) {
+    return true;
+  }
+  if (length > HTTPS_REQUEST_MAX_HEAD_LENGTH) {
+    return false;
+  }
+  size_t capacity = _headCapacity > 0 ? _headCapacity : HTTPS_REQUEST_HEAD_BUFFER_SIZE;
+  while(capacity < length) {
+    capacity *= 2;
+  }
+  if (capacity > HTTPS_REQUEST_MAX_HEAD_LENGTH) {
+    capacity = HTTPS_REQUEST_MAX_HEAD_LENGTH;
+  }
+  // Headers are only stored once the head is complete, so nothing refers to the old buffer
+  char * buffer = new char[capacity];
+  if (_headLength > 0) {
+    memcpy(buffer, _headBuffer, _headLength);
+  }
+  delete[] _headBuffer;
+  _headBuffer = buffer;
+  _headCapacity = capacity;
+  return true;
+}
+
+/**
+ * Moves the next line from the receive buffer to the head buffer.
+ *
+ * Returns true if the line is complete. It can then be found in _headBuffer, starting at
+ * _lineStart and ending at _headLength (without the \r\n). If the line is incomplete, the
+ * data that is available so far is moved anyway, and the next call will continue with it.
+ * There is always room for one more character after a complete line.
+ */
+bool HTTPConnection::readLine(size_t lengthLimit) {
   while(_bufferProcessed < _bufferUnusedIdx) {
-    char newChar = _receiveBuffer[_bufferProcessed];
-
-    if ( newChar == '\r') {
-      // Look ahead for \n (if not possible, wait for next round
-      if (_bufferProcessed+1 < _bufferUnusedIdx) {
-        if (_receiveBuffer[_bufferProcessed+1] == '\n') {
-          _bufferProcessed += 2;
-          _parserLine.parsingFinished = true;
-          return;
-        } else {
-          // Line has not been terminated by \r\n
-          HTTPS_LOGW("Line without \\r\\n (got only \\r). FID=%d", _socket);
-          clientError();
-          return;
-        }
+    char * data = _receiveBuffer + _bufferProcessed;
+    size_t available = _bufferUnusedIdx - _bufferProcessed;
+    char * lineEnd = (char*)findChar(data, available, '\r');
+    size_t lineLength = (lineEnd == NULL) ? available : lineEnd - data;
+
+    // Check that the max line length and the size of the head buffer are not exceeded
+    if (_headLength - _lineStart + lineLength > lengthLimit || !reserveHead(_headLength + lineLength + 1)) {
+      HTTPS_LOGW("Header length exceeded. FID=%d", _socket);
+      if (_connectionState == STATE_INITIAL) {
+        serverError();
+      } else {
+        headerTooLarge();
       }
-    } else {
-      _parserLine.text += newChar;
-      _bufferProcessed += 1;
+      return false;
     }
 
-    // Check that the max request string size is not exceeded
-    if (_parserLine.text.length() > lengthLimit) {
-      HTTPS_LOGW("Header length exceeded. FID=%d", _socket);
-      serverError();
-      return;
+    memcpy(_headBuffer + _headLength, data, lineLength);
+    _headLength += lineLength;
+    _bufferProcessed += lineLength;
+
+    if (lineEnd == NULL) {
+      // Wait for the rest of the line
+      return false;
     }
+
+    // Look ahead for \n (if not possible, wait for next round)
+    if (_bufferProcessed+1 < _bufferUnusedIdx) {
+      if (_receiveBuffer[_bufferProcessed+1] == '\n') {
+        _bufferProcessed += 2;
+        return true;
+      } else {
+        // Line has not been terminated by \r\n
+        HTTPS_LOGW("Line without \\r\\n (got only \\r). FID=%d", _socket);
+        clientError();
+        return false;
+      }
+    }
+    return false;
+  }
+  return false;
+}
+
+/**
+ * Adds the header lines in the head buffer to the request's headers. The lines have been checked
+ * by readLine() and are terminated by \n.
+ */
+void HTTPConnection::storeHeaders() {
+  const char * headEnd = _headBuffer + _lineStart;
+  size_t lineCount = 0;
+  for(const char * c = _headBuffer; c < headEnd; c++) {
+    if (*c == '\n') {
+      lineCount++;
+    }
+  }
+  _httpHeaders->reserve(lineCount);
+
+  const char * line = _headBuffer;
+  while(line < headEnd) {
+    const char * lineEnd = findChar(line, headEnd - line, '\n');
+    const char * colon = findChar(line, lineEnd - line, ':');
+    // The header refers to the head buffer, which is not changed until the next request
+    HTTPSpan name(line, colon - line);
+    HTTPSpan value(colon + 2, lineEnd - colon - 2);
+    _httpHeaders->setSpan(name, value);
+    HTTPS_LOGD("Header: %.*s = %.*s (FID=%d)", (int)name.length(), name.data(), (int)value.length(), value.data(), _socket);
+    line = lineEnd + 1;
   }
 }
 
@@ -322,6 +592,13 @@ void HTTPConnection::signalRequestError() {
   serverError();
 }
 
+/**
+ * Answers a request that the client has sent in a malformed way with 400 and closes the connection
+ */
+void HTTPConnection::signalClientError() {
+  clientError();
+}
+
 /**
  * Returns the cache size that should be cached (in the response) to enable keep-alive requests.
  *
@@ -331,7 +608,37 @@ size_t HTTPConnection::getCacheSize() {
   return (_isKeepAlive ? HTTPS_KEEPALIVE_CACHESIZE : 0);
 }
 
+/**
+ * Returns true if the response to the current request may use chunked transfer encoding
+ */
+bool HTTPConnection::canSendChunked() {
+  return _isHTTP11;
+}
+
+/**
+ * Returns the arena that holds the data of the current request
+ */
+RequestArena * HTTPConnection::getArena() {
+  return &_arena;
+}
+
+/**
+ * Continues the handshake of a connection in STATE_HANDSHAKE. Plain HTTP has no handshake.
+ */
+void HTTPConnection::continueHandshake() {
+
+}
+
 void HTTPConnection::loop() {
+  // A TLS connection has to complete its handshake before the request can be read
+  if (_connectionState == STATE_HANDSHAKE) {
+    continueHandshake();
+    if (_connectionState == STATE_HANDSHAKE) {
+      _readiness = READINESS_UNKNOWN;
+      return;
+    }
+  }
+
   // First, update the buffer
   // newByteCount will contain the number of new bytes that have to be processed
   updateBuffer();
@@ -344,247 +651,296 @@ void HTTPConnection::loop() {
     closeConnection();
   }
 
-  if (!isClosed() && isTimeoutExceeded()) {
-    HTTPS_LOGI("Connection timeout. FID=%d", _socket);
-    closeConnection();
-  }
-
   if (!isError()) {
-    // State machine (Reading request, reading headers, ...)
-    switch(_connectionState) {
-    case STATE_INITIAL: // Read request line
-      readLine(HTTPS_REQUEST_MAX_REQUEST_LENGTH);
-      if (_parserLine.parsingFinished && !isClosed()) {
-        // Find the method
-        size_t spaceAfterMethodIdx = _parserLine.text.find(' ');
-        if (spaceAfterMethodIdx == std::string::npos) {
-          HTTPS_LOGW("Missing space after method");
-          clientError();
-          break;
-        }
-        _httpMethod = _parserLine.text.substr(0, spaceAfterMethodIdx);
-
-        // Find the resource string:
-        size_t spaceAfterResourceIdx = _parserLine.text.find(' ', spaceAfterMethodIdx + 1);
-        if (spaceAfterResourceIdx == std::string::npos) {
-          HTTPS_LOGW("Missing space after resource");
-          clientError();
-          break;
-        }
-        _httpResource = _parserLine.text.substr(spaceAfterMethodIdx + 1, spaceAfterResourceIdx - _httpMethod.length() - 1);
+    // Process the data in the buffer as far as possible. If the client has sent several requests
+    // at once (pipelining), they are all handled in this call, so the responses are sent back-to-back.
+    bool continueProcessing = true;
+    while(continueProcessing) {
+      int previousState = _connectionState;
+
+      // State machine (Reading request, reading headers, ...)
+      switch(_connectionState) {
+      case STATE_INITIAL: // Read request line
+        if (readLine(HTTPS_REQUEST_MAX_REQUEST_LENGTH) && !isClosed()) {
+          const char * line = _headBuffer + _lineStart;
+          const char * lineEnd = _headBuffer + _headLength;
+
+          // Find the method
+          const char * spaceAfterMethod = findChar(line, lineEnd - line, ' ');
+          if (spaceAfterMethod == NULL) {
+            HTTPS_LOGW("Missing space after method");
+            clientError();
+            break;
+          }
+          _httpMethod.assign(line, spaceAfterMethod - line);
+          _httpMethodId = parseMethod(_httpMethod);
+
+          // Find the resource string:
+          const char * resource = spaceAfterMethod + 1;
+          const char * spaceAfterResource = findChar(resource, lineEnd - resource, ' ');
+          if (spaceAfterResource == NULL) {
+            HTTPS_LOGW("Missing space after resource");
+            clientError();
+            break;
+          }
+          _httpResource.assign(resource, spaceAfterResource - resource);
 
-        _parserLine.parsingFinished = false;
-        _parserLine.text = "";
-        HTTPS_LOGI("Request: %s %s (FID=%d)", _httpMethod.c_str(), _httpResource.c_str(), _socket);
-        _connectionState = STATE_REQUEST_FINISHED;
-      }
+          // The rest of the line is the protocol version
+          const char * version = spaceAfterResource + 1;
+          _isHTTP11 = HTTPSpan(version, lineEnd - version).equals("HTTP/1.1");
+
+          // The request line is not needed anymore, the headers can use the whole head buffer
+          _headLength = 0;
+          _lineStart = 0;
+          HTTPS_LOGI("Request: %s %s (FID=%d)", _httpMethod.c_str(), _httpResource.c_str(), _socket);
+          _connectionState = STATE_REQUEST_FINISHED;
+        }
 
-      break;
-    case STATE_REQUEST_FINISHED: // Read headers
+        break;
+      case STATE_REQUEST_FINISHED: // Read headers
 
-      while (_bufferProcessed < _bufferUnusedIdx && !isClosed()) {
-        readLine(HTTPS_REQUEST_MAX_HEADER_LENGTH);
-        if (_parserLine.parsingFinished && _connectionState != STATE_ERROR) {
+        // Parse all complete lines that are in the buffer
+        while (readLine(HTTPS_REQUEST_MAX_HEADER_LENGTH) && !isClosed()) {
+          const char * line = _headBuffer + _lineStart;
+          size_t lineLength = _headLength - _lineStart;
 
-          if (_parserLine.text.empty()) {
+          if (lineLength == 0) {
             HTTPS_LOGD("Headers finished, FID=%d", _socket);
+            // The head buffer does not move anymore, so the headers can refer to it
+            storeHeaders();
+            if (!HTTPRequest::hasValidTransferEncoding(_httpHeaders)) {
+              HTTPSpan transferEncoding = _httpHeaders->getValueSpan(HEADER_TRANSFER_ENCODING);
+              HTTPS_LOGW("Unsupported transfer coding: %.*s", (int)transferEncoding.length(), transferEncoding.data());
+              clientError();
+              break;
+            }
             _connectionState = STATE_HEADERS_FINISHED;
+            // The head is complete, now the body may take the regular connection timeout
+            setTimeout(HTTPS_CONNECTION_TIMEOUT);
 
             // Break, so that the rest of the body does not get flushed through
-            _parserLine.parsingFinished = false;
-            _parserLine.text = "";
             break;
           } else {
-            int idxColon = _parserLine.text.find(':');
-            if ( (idxColon != std::string::npos) && (_parserLine.text[idxColon+1]==' ') ) {
-              _httpHeaders->set(new HTTPHeader(
-                  _parserLine.text.substr(0, idxColon),
-                  _parserLine.text.substr(idxColon+2)
-              ));
-              HTTPS_LOGD("Header: %s = %s (FID=%d)", _parserLine.text.substr(0, idxColon).c_str(), _parserLine.text.substr(idxColon+2).c_str(), _socket);
-            } else {
-              HTTPS_LOGW("Malformed request header: %s", _parserLine.text.c_str());
+            // A bare \n would break the line into two when the headers are stored
+            const char * colon = findChar(line, lineLength, ':');
+            if (colon == NULL || colon + 1 == line + lineLength || colon[1] != ' ' || findChar(line, lineLength, '\n') != NULL) {
+              HTTPS_LOGW("Malformed request header: %.*s", (int)lineLength, line);
               clientError();
               break;
             }
           }
 
-          _parserLine.parsingFinished = false;
-          _parserLine.text = "";
+          // readLine() has left room for the line break
+          _headBuffer[_headLength++] = '\n';
+          _lineStart = _headLength;
         }
-      }
 
-      break;
-    case STATE_HEADERS_FINISHED: // Handle body
-      {
-        HTTPS_LOGD("Resolving resource...");
-        ResolvedResource resolvedResource;
-
-        // Check which kind of node we need (Websocket or regular)
-        bool websocketRequested = checkWebsocket();
-
-        _resResolver->resolveNode(_httpMethod, _httpResource, resolvedResource, websocketRequested ? WEBSOCKET : HANDLER_CALLBACK);
-
-        // Is there any match (may be the defaultNode, if it is configured)
-        if (resolvedResource.didMatch()) {
-          // Check for client's request to keep-alive if we have a handler function.
-          if (resolvedResource.getMatchingNode()->_nodeType == HANDLER_CALLBACK) {
-            // Did the client set connection:keep-alive?
-            HTTPHeader * connectionHeader = _httpHeaders->get("Connection");
-            std::string connectionHeaderValue = "";
-            if (connectionHeader != NULL) {
-              connectionHeaderValue += connectionHeader->_value;
-              std::transform(
-                connectionHeaderValue.begin(),
-                connectionHeaderValue.end(),
-                connectionHeaderValue.begin(),
-                [](unsigned char c){ return ::tolower(c); }
-              );
-            }
-            if (std::string("keep-alive").compare(connectionHeaderValue)==0) {
-              HTTPS_LOGD("Keep-Alive activated. FID=%d", _socket);
-              _isKeepAlive = true;
-            } else {
-              HTTPS_LOGD("Keep-Alive disabled. FID=%d", _socket);
-              _isKeepAlive = false;
-            }
-          } else {
-            _isKeepAlive = false;
-          }
+        break;
+      case STATE_HEADERS_FINISHED: // Handle body
+        {
+          HTTPS_LOGD("Resolving resource...");
+          ResolvedResource resolvedResource(&_arena);
 
-          // Create request context
-          HTTPRequest req  = HTTPRequest(
-            this,
-            _httpHeaders,
-            resolvedResource.getMatchingNode(),
-            _httpMethod,
-            resolvedResource.getParams(),
-            _httpResource
-          );
-          HTTPResponse res = HTTPResponse(this);
-
-          // Add default headers to the response
-          auto allDefaultHeaders = _defaultHeaders->getAll();
-          for(std::vector<HTTPHeader*>::iterator header = allDefaultHeaders->begin(); header != allDefaultHeaders->end(); ++header) {
-            res.setHeader((*header)->_name, (*header)->_value);
-          }
+          // Check which kind of node we need (Websocket or regular)
+          bool websocketRequested = checkWebsocket();
 
-          // Find the request handler callback
-          HTTPSCallbackFunction * resourceCallback;
-          if (websocketRequested) {
-            // For the websocket, we use the handshake callback defined below
-            resourceCallback = &handleWebsocketHandshake;
-          } else {
-            // For resource nodes, we use the callback defined by the node itself
-            resourceCallback = ((ResourceNode*)resolvedResource.getMatchingNode())->_callback;
-          }
+          _resResolver->resolveNode(_httpMethodId, _httpMethod, _httpResource, resolvedResource, websocketRequested ? WEBSOCKET : HANDLER_CALLBACK);
 
-          // Get the current middleware chain
-          auto vecMw = _resResolver->getMiddleware();
+          // If the path exists, but not for this method, the request is answered with 405 by an
+          // internal handler, which is not a websocket handshake
+          bool methodAllowed = resolvedResource.didMatch();
+          if (!methodAllowed) {
+            websocketRequested = false;
+          }
 
-          // Anchor of the chain is the actual resource. The call to the handler is bound here
-          std::function<void()> next = std::function<void()>(std::bind(resourceCallback, &req, &res));
+          // Is there any match (may be the defaultNode, if it is configured)
+          if (methodAllowed || resolvedResource.getAllowedMethods() != 0) {
+            // Check for client's request to keep-alive if we have a handler function.
+            // Static routes and 405 responses always use handler functions
+            if (resolvedResource.getMatchingNode() == NULL || resolvedResource.getMatchingNode()->_nodeType == HANDLER_CALLBACK) {
+              // Did the client set connection:keep-alive?
+              if (_httpHeaders->getValueSpan(HEADER_CONNECTION).equalsIgnoreCase("keep-alive") && !_isDraining) {
+                HTTPS_LOGD("Keep-Alive activated. FID=%d", _socket);
+                _isKeepAlive = true;
+              } else {
+                HTTPS_LOGD("Keep-Alive disabled. FID=%d", _socket);
+                _isKeepAlive = false;
+              }
+            } else {
+              _isKeepAlive = false;
+            }
 
-          // Go back in the middleware chain and glue everything together
-          auto itMw = vecMw.rbegin();
-          while(itMw != vecMw.rend()) {
-            next = std::function<void()>(std::bind((*itMw), &req, &res, next));
-            itMw++;
-          }
+            // The handler may wait for more data (e.g. for the request body), so it has to check
+            // the socket on its own from here on
+            _readiness = READINESS_UNKNOWN;
+
+            // Create request context
+            HTTPRequest req  = HTTPRequest(
+              this,
+              _httpHeaders,
+              resolvedResource.getMatchingNode(),
+              resolvedResource.getStaticRoute(),
+              _httpMethod,
+              _httpMethodId,
+              resolvedResource.getParams(),
+              _httpResource
+            );
+            HTTPResponse res = HTTPResponse(this);
+
+            // Add default headers to the response
+            res.setDefaultHeaders(_defaultHeaders);
+
+            // The response to a HEAD request has the headers of a GET response, but no body
+            if (_httpMethodId == METHOD_HEAD) {
+              res.omitBody();
+            }
 
-          // We insert the internal validation middleware at the start of the chain:
-          next = std::function<void()>(std::bind(&validationMiddleware, &req, &res, next));
+            // If the server shuts down, the client must not send further requests on this connection
+            if (_isDraining) {
+              res.setHeader("Connection", "close");
+            }
 
-          // Call the whole chain
-          next();
+            // Find the request handler callback
+            HTTPSCallbackFunction * resourceCallback;
+            if (!methodAllowed) {
+              HTTPS_LOGW("Method not allowed: %s", _httpMethod.c_str());
+              res.setHeader("Allow", getMethodNames(resolvedResource.getAllowedMethods()));
+              resourceCallback = &handleMethodNotAllowed;
+            } else if (websocketRequested) {
+              // For the websocket, we use the handshake callback defined below
+              resourceCallback = &handleWebsocketHandshake;
+            } else if (resolvedResource.getStaticRoute() != NULL) {
+              resourceCallback = resolvedResource.getStaticRoute()->_callback;
+            } else {
+              // For resource nodes, we use the callback defined by the node itself
+              resourceCallback = ((ResourceNode*)resolvedResource.getMatchingNode())->_callback;
+            }
 
-          // The callback-function should have read all of the request body.
-          // However, if it does not, we need to clear the request body now,
-          // because otherwise it would be parsed in the next request.
-          if (!req.requestComplete()) {
-            HTTPS_LOGW("Callback function did not parse full request body");
-            req.discardRequestBody();
-          }
+            // Pass the request through the middleware chain to the handler. The middleware is
+            // skipped for 405 responses, which have no node.
+            if (methodAllowed) {
+              _resResolver->getMiddlewareChain()->invoke(&req, &res, resourceCallback);
+            } else {
+              resourceCallback(&req, &res);
+            }
+            _responseCount++;
+
+            // The callback-function should have read all of the request body.
+            // However, if it does not, we need to clear the request body now,
+            // because otherwise it would be parsed in the next request.
+            if (!req.requestComplete()) {
+              HTTPS_LOGW("Callback function did not parse full request body");
+              req.discardRequestBody();
+            }
 
-          // Finally, after the handshake is done, we create the WebsocketHandler and change the internal state.
-          if(websocketRequested) {
-            _wsHandler = ((WebsocketNode*)resolvedResource.getMatchingNode())->newHandler();
-            _wsHandler->initialize(this);  // make websocket with this connection 
-            _connectionState = STATE_WEBSOCKET;
-          } else {
-            // Handling the request is done
-            HTTPS_LOGD("Handler function done, request complete");
-
-            // Now we need to check if we can use keep-alive to reuse the SSL connection
-            // However, if the client did not set content-size or defined connection: close,
-            // we have no chance to do so.
-            if (!_isKeepAlive) {
-              // No KeepAlive -> We are done. Transition to next state.
-              if (!isClosed()) {
-                _connectionState = STATE_BODY_FINISHED;
-              }
+            // Finally, after the handshake is done, we create the WebsocketHandler and change the internal state.
+            if(websocketRequested) {
+              _wsHandler = ((WebsocketNode*)resolvedResource.getMatchingNode())->newHandler();
+              _wsHandler->initialize(this);  // make websocket with this connection 
+              _connectionState = STATE_WEBSOCKET;
+              // Websocket connections don't time out
+              _timeoutTimer.cancel();
             } else {
-              if (res.isResponseBuffered()) {
-                // If the response could be buffered:
-                res.setHeader("Connection", "keep-alive");
-                res.finalize();
-                if (_clientState != CSTATE_CLOSED) {
-                  // Refresh the timeout for the new request
-                  refreshTimeout();
-                  // Reset headers for the new connection
-                  _httpHeaders->clearAll();
-                  // Go back to initial state
-                  _connectionState = STATE_INITIAL;
+              // Handling the request is done
+              HTTPS_LOGD("Handler function done, request complete");
+
+              // Now we need to check if we can use keep-alive to reuse the SSL connection
+              // However, if the client did not set content-size or defined connection: close,
+              // we have no chance to do so.
+              if (!_isKeepAlive) {
+                // No KeepAlive -> We are done. Transition to next state.
+                if (!isClosed()) {
+                  _connectionState = STATE_BODY_FINISHED;
+                }
+              } else {
+                if (res.isResponseBuffered() || res.isResponseChunked() || res.isResponseLengthDelimited()) {
+                  // If the response could be buffered, is sent in chunks or has been streamed with
+                  // a matching Content-Length (unless drain() has been called in the meantime):
+                  res.setHeader("Connection", _isDraining ? "close" : "keep-alive");
+                  res.finalize();
+                  if (_clientState != CSTATE_CLOSED && !_isDraining) {
+                    // The connection may now idle until the next request starts
+                    _headerTimeoutSet = false;
+                    setTimeout(HTTPS_CONNECTION_TIMEOUT);
+                    // Reset headers for the new connection
+                    _httpHeaders->clearAll();
+                    _headLength = 0;
+                    _lineStart = 0;
+                    // Go back to initial state
+                    _connectionState = STATE_INITIAL;
+                  }
+                }
+                // The response could not be buffered or the client has closed:
+                if (!isClosed() && _connectionState!=STATE_INITIAL) {
+                  _connectionState = STATE_BODY_FINISHED;
                 }
-              }
-              // The response could not be buffered or the client has closed:
-              if (!isClosed() && _connectionState!=STATE_INITIAL) {
-                _connectionState = STATE_BODY_FINISHED;
               }
             }
+          } else {
+            // No match (no default route configured, nothing does match)
+            HTTPS_LOGW("Could not find a matching resource");
+            serverError();
           }
-        } else {
-          // No match (no default route configured, nothing does match)
-          HTTPS_LOGW("Could not find a matching resource");
-          serverError();
-        }
 
+        }
+        // Request and response are gone, so everything that has been allocated for them can be
+        // released in one step
+        _httpHeaders->clearAll();
+        _arena.reset();
+        break;
+      case STATE_BODY_FINISHED: // Request is complete
+        closeConnection();
+        break;
+      case STATE_CLOSING: // As long as we are in closing state, we call closeConnection() again and wait for it to finish or timeout
+        // Nothing can have changed if the client has not sent anything
+        if (_readiness != READINESS_IDLE) {
+          closeConnection();
+        }
+        break;
+      case STATE_WEBSOCKET: // Do handling of the websocket
+        if(pendingBufferSize() > 0) {
+          HTTPS_LOGD("Calling WS handler, FID=%d", _socket);
+          // Like request handlers, the websocket handler checks the socket on its own
+          _readiness = READINESS_UNKNOWN;
+          _wsHandler->loop();
+        }
+        // If the handler has terminated the connection, clean up and close the socket too
+        if (_wsHandler->closed()) {
+          HTTPS_LOGI("WS closed, freeing Handler, FID=%d", _socket);
+          delete _wsHandler;
+          _wsHandler = nullptr;
+          _connectionState = STATE_CLOSING;
+        }
+        break;
+      default:;
       }
-      break;
-    case STATE_BODY_FINISHED: // Request is complete
-      closeConnection();
-      break;
-    case STATE_CLOSING: // As long as we are in closing state, we call closeConnection() again and wait for it to finish or timeout
-      closeConnection();
-      break;
-    case STATE_WEBSOCKET: // Do handling of the websocket
-      refreshTimeout();  // don't timeout websocket connection
-      if(pendingBufferSize() > 0) {
-        HTTPS_LOGD("Calling WS handler, FID=%d", _socket);
-        _wsHandler->loop();
-      }
-      // If the handler has terminated the connection, clean up and close the socket too
-      if (_wsHandler->closed()) {
-        HTTPS_LOGI("WS closed, freeing Handler, FID=%d", _socket);
-        delete _wsHandler;
-        _wsHandler = nullptr;
-        _connectionState = STATE_CLOSING;
-      }
-      break;
-    default:;
+
+      // Continue if the state machine advanced and the next state can make use of buffered data
+      continueProcessing = _connectionState != previousState && (
+        _connectionState == STATE_REQUEST_FINISHED ||
+        _connectionState == STATE_HEADERS_FINISHED ||
+        (_connectionState == STATE_INITIAL && _bufferProcessed < _bufferUnusedIdx)
+      );
+    }
+
+    // Send the responses of this loop. Responses to pipelined requests are sent together
+    if (!isClosed()) {
+      flushBuffer();
     }
   }
 
+  // The readiness information is only valid for the current loop
+  _readiness = READINESS_UNKNOWN;
 }
 
 
 bool HTTPConnection::checkWebsocket() {
-  if(_httpMethod == "GET" &&
-     !_httpHeaders->getValue("Host").empty() &&
-      _httpHeaders->getValue("Upgrade") == "websocket" &&
-      _httpHeaders->getValue("Connection").find("Upgrade") != std::string::npos &&
-     !_httpHeaders->getValue("Sec-WebSocket-Key").empty() &&
-      _httpHeaders->getValue("Sec-WebSocket-Version") == "13") {
+  if(_httpMethodId == METHOD_GET &&
+     !_httpHeaders->getValueSpan(HEADER_HOST).empty() &&
+      _httpHeaders->getValueSpan(HEADER_UPGRADE).equals("websocket") &&
+      _httpHeaders->getValueSpan(HEADER_CONNECTION).contains("Upgrade") &&
+     !_httpHeaders->getValueSpan(HEADER_SEC_WEBSOCKET_KEY).empty() &&
+      _httpHeaders->getValueSpan(HEADER_SEC_WEBSOCKET_VERSION).equals("13")) {
 
       HTTPS_LOGI("Upgrading to WS, FID=%d", _socket);
       return true;
@@ -597,16 +953,18 @@ bool HTTPConnection::checkWebsocket() {
  */
 void validationMiddleware(HTTPRequest * req, HTTPResponse * res, std::function<void()> next) {
   bool valid = true;
-  // Get the matched node
+  // Get the matched node. Static routes have no validators.
   HTTPNode * node = req->getResolvedNode();
   // Get the parameters
   ResourceParameters * params = req->getParams();
 
   // Iterate over the validators and run them
-  std::vector<HTTPValidator*> * validators = node->getValidators();
-  for(std::vector<HTTPValidator*>::iterator validator = validators->begin(); valid && validator != validators->end(); ++validator) {
-    std::string param = params->getUrlParameter((*validator)->_idx);
-    valid = ((*validator)->_validatorFunction)(param);
+  if (node != NULL) {
+    std::vector<HTTPValidator*> * validators = node->getValidators();
+    for(std::vector<HTTPValidator*>::iterator validator = validators->begin(); valid && validator != validators->end(); ++validator) {
+      std::string param = params->getUrlParameter((*validator)->_idx);
+      valid = ((*validator)->_validatorFunction)(param);
+    }
   }
 
   if (valid) {
@@ -630,6 +988,19 @@ void handleWebsocketHandshake(HTTPRequest * req, HTTPResponse * res) {
   res->print("");
 }
 
+/**
+ * Handler function for requests to an existing path with a method that none of the path's nodes
+ * accepts. HTTPConnection sets the Allow header before it is called.
+ */
+void handleMethodNotAllowed(HTTPRequest * req, HTTPResponse * res) {
+  // The connection can be kept alive, so the body must not be taken for the next request
+  req->discardRequestBody();
+  res->setStatusCode(405);
+  res->setStatusText("Method Not Allowed");
+  res->setHeader("Content-Type", "text/html");
+  res->print("<h1>405 Method Not Allowed</h1>");
+}
+
 /**
  * Function used to compute the value of the Sec-WebSocket-Accept during Websocket handshake
  */
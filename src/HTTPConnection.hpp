@@ -18,6 +18,12 @@
 
 #include "HTTPHeaders.hpp"
 #include "HTTPHeader.hpp"
+#include "HTTPMethod.hpp"
+#include "HTTPSpan.hpp"
+#include "RequestArena.hpp"
+#include "util.hpp"
+#include "Timer.hpp"
+#include "TimerWheel.hpp"
 
 #include "ResourceResolver.hpp"
 #include "ResolvedResource.hpp"
@@ -36,35 +42,55 @@ namespace httpsserver {
  */
 class HTTPConnection : private ConnectionContext {
 public:
-  HTTPConnection(ResourceResolver * resResolver);
+  HTTPConnection(ResourceResolver * resResolver, TimerWheel * timerWheel);
   virtual ~HTTPConnection();
 
   virtual int initialize(int serverSocketID, HTTPHeaders *defaultHeaders);
   virtual void closeConnection();
   virtual bool isSecure();
+  void reset();
+  void drain();
 
   void loop();
   bool isClosed();
   bool isError();
 
+  int getSocket();
+  void setReadiness(bool socketReadable);
+
+  unsigned long getResponseCount();
+  unsigned long getSocketWriteCount();
+
 protected:
   friend class HTTPRequest;
   friend class HTTPResponse;
   friend class WebsocketInputStreambuf;
 
   virtual size_t writeBuffer(byte* buffer, size_t length);
+  virtual void flushBuffer();
+  virtual size_t sendBytes(byte* buffer, size_t length);
   virtual size_t readBytesToBuffer(byte* buffer, size_t length);
   virtual bool canReadData();
   virtual size_t pendingByteCount();
+  virtual void continueHandshake();
+  virtual void handleTimeout();
+  void setTimeout(unsigned long timeout);
+  void refreshTimeout();
+
+  // Runs the current timeout of the connection (idle, header, handshake or shutdown)
+  Timer _timeoutTimer;
+  TimerWheel * _timerWheel;
 
-  // Timestamp of the last transmission action
-  unsigned long _lastTransmissionTS;
+  // True if the header timeout for the current request has been started
+  bool _headerTimeoutSet;
 
-  // Timestamp of when the shutdown was started
-  unsigned long _shutdownTS;
+  // True if the server shuts down and the connection must not be kept alive
+  bool _isDraining;
 
   // Internal state machine of the connection:
   //
+  // (TLS only: STATE_UNDEFINED -- initialize() --> STATE_HANDSHAKE -- handshake done --> STATE_INITIAL)
+  //
   // O --- > STATE_UNDEFINED -- initialize() --> STATE_INITIAL -- get / http/1.1 --> STATE_REQUEST_FINISHED --.
   //                     |                          |                                       |                 |
   //                     |                          |                                       |                 | Host: ...\r\n
@@ -82,6 +108,8 @@ protected:
 
     // The connection has not been established yet
     STATE_UNDEFINED,
+    // The TLS handshake is in progress (HTTPS only)
+    STATE_HANDSHAKE,
     // The connection has just been created
     STATE_INITIAL,
     // The request line has been parsed
@@ -100,6 +128,14 @@ protected:
     STATE_ERROR
   } _connectionState;
 
+  // Result of the last readiness check on the socket, done by the server for all connections
+  // at once (see setReadiness()). As long as it is unknown, canReadData() checks the socket itself.
+  enum {
+    READINESS_UNKNOWN,
+    READINESS_READABLE,
+    READINESS_IDLE
+  } _readiness;
+
   enum {
     CSTATE_UNDEFINED,
     CSTATE_ACTIVE,
@@ -109,18 +145,24 @@ protected:
 private:
   void serverError();
   void clientError();
-  void readLine(int lengthLimit);
-
-  bool isTimeoutExceeded();
-  void refreshTimeout();
+  void headerTooLarge();
+  bool reserveHead(size_t length);
+  bool readLine(size_t lengthLimit);
+  void storeHeaders();
 
   int updateBuffer();
   size_t pendingBufferSize();
+  bool isInputClosed();
 
   void signalClientClose();
   void signalRequestError();
+  void signalClientError();
   size_t readBuffer(byte* buffer, size_t length);
+  size_t peekBuffer(byte** data);
+  void consumeBuffer(size_t length);
   size_t getCacheSize();
+  bool canSendChunked();
+  RequestArena * getArena();
   bool checkWebsocket();
 
   // The receive buffer
@@ -131,6 +173,15 @@ private:
   // The index on the receive_buffer that is the first one which is empty at the end.
   int _bufferUnusedIdx;
 
+  // The send buffer, see writeBuffer()
+  byte _sendBuffer[HTTPS_CONNECTION_SEND_BUFFER_SIZE];
+  // Length of the data in _sendBuffer
+  size_t _sendBufferLength;
+
+  // Statistics: Number of responses and calls to sendBytes() over the lifetime of this object
+  unsigned long _responseCount;
+  unsigned long _socketWriteCount;
+
   // Socket address, length etc for the connection
   struct sockaddr _sockAddr;
   socklen_t _addrLen;
@@ -139,23 +190,38 @@ private:
   // Resource resolver used to resolve resources
   ResourceResolver * _resResolver;
 
-  // The parser line. The struct is used to read the next line up to the \r\n in readLine()
-  struct {
-    std::string text = "";
-    bool parsingFinished = false;
-  } _parserLine;
+  // The request head. Lines are copied here from the receive buffer (with \n as line break), so
+  // that the parsed headers can refer to it and don't need to be copied again. The request line
+  // is discarded once method and resource have been extracted. The buffer is allocated on demand
+  // and grows up to HTTPS_REQUEST_MAX_HEAD_LENGTH, see reserveHead().
+  char * _headBuffer;
+  // Size of _headBuffer
+  size_t _headCapacity;
+  // Length of the data in _headBuffer
+  size_t _headLength;
+  // Index on _headBuffer where the line that is currently parsed starts
+  size_t _lineStart;
 
   // HTTP properties: Method, Request, Headers
   std::string _httpMethod;
+  // The method as it has been parsed from _httpMethod
+  HTTPMethodId _httpMethodId;
   std::string _httpResource;
   HTTPHeaders * _httpHeaders;
 
+  // Memory for the headers, parameters and response cache of the current request. It is reset
+  // when the request is complete.
+  RequestArena _arena;
+
   // Default headers that are applied to every response
   HTTPHeaders * _defaultHeaders;
 
   // Should we use keep alive
   bool _isKeepAlive;
 
+  // Did the client use HTTP/1.1 (and does therefore support chunked transfer encoding)
+  bool _isHTTP11;
+
   //Websocket connection
   WebsocketHandler * _wsHandler;
 
@@ -163,6 +229,8 @@ private:
 
 void handleWebsocketHandshake(HTTPRequest * req, HTTPResponse * res);
 
+void handleMethodNotAllowed(HTTPRequest * req, HTTPResponse * res);
+
 std::string websocketKeyResponseHash(std::string const &key);
 
 void validationMiddleware(HTTPRequest * req, HTTPResponse * res, std::function<void()> next);
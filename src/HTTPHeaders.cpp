@@ -2,58 +2,320 @@
 
 namespace httpsserver {
 
-HTTPHeaders::HTTPHeaders() {
-  _headers = new std::vector<HTTPHeader *>();
+// FNV-1a hash over the lower-case name. The constexpr variant is used for the case labels in
+// identify(), so two well-known headers with the same hash would not compile.
+#define HEADER_HASH_BASIS 2166136261u
+#define HEADER_HASH_PRIME 16777619u
 
+static constexpr uint32_t headerHash(const char * name, uint32_t hash = HEADER_HASH_BASIS) {
+  return *name == 0 ? hash : headerHash(name + 1,
+    (hash ^ (uint8_t)((*name >= 'A' && *name <= 'Z') ? *name + ('a' - 'A') : *name)) * HEADER_HASH_PRIME);
+}
+
+// Names of the well-known headers, in the order of HTTPHeaderId
+static const char * const WELL_KNOWN_NAMES[HEADER_UNKNOWN] = {
+  "Host",
+  "Connection",
+  "Content-Length",
+  "Content-Type",
+  "Transfer-Encoding",
+  "Upgrade",
+  "Sec-WebSocket-Key",
+  "Sec-WebSocket-Version",
+  "Sec-WebSocket-Protocol",
+  "Sec-WebSocket-Extensions",
+  "Sec-WebSocket-Accept",
+  "Accept-Encoding",
+  "Authorization",
+  "If-None-Match",
+  "Range"
+};
+
+HTTPHeaders::HTTPHeaders(RequestArena * arena):
+  _arena(arena),
+  _entries(ArenaAllocator<HeaderEntry>(arena)) {
+  _isSerialized = false;
+  for(int i = 0; i < HEADER_UNKNOWN; i++) {
+    _wellKnown[i] = -1;
+  }
 }
 
 HTTPHeaders::~HTTPHeaders() {
   clearAll();
-  delete _headers;
 }
 
 HTTPHeader * HTTPHeaders::get(std::string const &name) {
-  for(std::vector<HTTPHeader*>::iterator header = _headers->begin(); header != _headers->end(); ++header) {
-    if ((*header)->_name.compare(name)==0) {
-      return (*header);
+  HTTPSpan nameSpan(name);
+  uint32_t hash = hashName(nameSpan);
+  int idx = find(nameSpan, hash, identify(nameSpan));
+  return idx < 0 ? NULL : materialize(_entries[idx]);
+}
+
+std::string HTTPHeaders::getValue(std::string const &name) {
+  return getValueSpan(name).str();
+}
+
+/**
+ * Returns the value of a header without copying it.
+ *
+ * The span is valid until the header is changed or the headers are cleared. An empty span
+ * is returned if the header is not set.
+ */
+HTTPSpan HTTPHeaders::getValueSpan(HTTPSpan const &name) {
+  int idx = find(name, hashName(name), identify(name));
+  return idx < 0 ? HTTPSpan() : _entries[idx].value;
+}
+
+/**
+ * Returns the value of a well-known header without searching for it
+ */
+HTTPSpan HTTPHeaders::getValueSpan(HTTPHeaderId id) {
+  if (id >= HEADER_UNKNOWN || _wellKnown[id] < 0) {
+    return HTTPSpan();
+  }
+  return _entries[_wellKnown[id]].value;
+}
+
+/**
+ * Adds a header or replaces the header with the same name. The header is copied and deleted
+ * afterwards, so it must have been allocated with new.
+ */
+void HTTPHeaders::set(HTTPHeader * header) {
+  set(header->_name, header->_value);
+  delete header;
+}
+
+/**
+ * Adds a header or replaces the header with the same name. Name and value are copied.
+ */
+void HTTPHeaders::set(HTTPSpan const &name, HTTPSpan const &value) {
+  store(name, hashName(name), identify(name), value, true);
+}
+
+/**
+ * Adds or replaces a well-known header. The value is copied.
+ */
+void HTTPHeaders::set(HTTPHeaderId id, HTTPSpan const &value) {
+  HTTPSpan name = getName(id);
+  store(name, hashName(name), id, value, true);
+}
+
+/**
+ * Sets a header by reference, without copying name and value.
+ *
+ * The memory that name and value point to must remain unchanged until clearAll() is called.
+ */
+void HTTPHeaders::setSpan(HTTPSpan const &name, HTTPSpan const &value) {
+  store(name, hashName(name), identify(name), value, false);
+}
+
+/**
+ * Makes room for count headers. Storage that is taken from the arena is only released when the arena
+ * is reset, so growing the table header by header would leave all previous copies of it behind.
+ */
+void HTTPHeaders::reserve(size_t count) {
+  _entries.reserve(count);
+}
+
+/**
+ * Returns the number of headers. Together with getNameAt() and getValueAt(), this can be used to
+ * iterate over the headers without creating HTTPHeader instances.
+ */
+size_t HTTPHeaders::getCount() {
+  return _entries.size();
+}
+
+HTTPSpan HTTPHeaders::getNameAt(size_t idx) {
+  return _entries[idx].name;
+}
+
+HTTPSpan HTTPHeaders::getValueAt(size_t idx) {
+  return _entries[idx].value;
+}
+
+/**
+ * Returns all headers as HTTPHeader instances. They remain owned by this object.
+ */
+std::vector<HTTPHeader *> * HTTPHeaders::getAll() {
+  _headers.clear();
+  for(size_t i = 0; i < _entries.size(); i++) {
+    _headers.push_back(materialize(_entries[i]));
+  }
+  return &_headers;
+}
+
+/**
+ * Creates the header block as it is sent in a response ("Name: value\r\n" for each header), so
+ * that it can be written with a single copy. It is available through getSerialized() until the
+ * headers are changed.
+ */
+void HTTPHeaders::serialize() {
+  _serialized.clear();
+  for(size_t i = 0; i < _entries.size(); i++) {
+    _serialized.append(_entries[i].name.data(), _entries[i].name.length());
+    _serialized.append(": ");
+    _serialized.append(_entries[i].value.data(), _entries[i].value.length());
+    _serialized.append("\r\n");
+  }
+  _isSerialized = true;
+}
+
+/**
+ * Returns the header block created by serialize(), or a span without data if the headers have
+ * been changed since.
+ */
+HTTPSpan HTTPHeaders::getSerialized() {
+  return _isSerialized ? HTTPSpan(_serialized) : HTTPSpan();
+}
+
+/**
+ * Deletes all headers
+ */
+void HTTPHeaders::clearAll() {
+  _isSerialized = false;
+  if (_arena != NULL) {
+    // Everything is released when the arena is reset. The table must not keep its storage, as it
+    // is taken from the arena as well. The list of getAll() is freed, so idle connections keep
+    // nothing.
+    std::vector<HeaderEntry, ArenaAllocator<HeaderEntry> >(ArenaAllocator<HeaderEntry>(_arena)).swap(_entries);
+    std::vector<HTTPHeader *>().swap(_headers);
+  } else {
+    for(size_t i = 0; i < _entries.size(); i++) {
+      releaseEntry(_entries[i]);
     }
+    _entries.clear();
+    _headers.clear();
+  }
+  for(int i = 0; i < HEADER_UNKNOWN; i++) {
+    _wellKnown[i] = -1;
   }
-  return NULL;
 }
 
-std::string HTTPHeaders::getValue(std::string const &name) {
-  for(std::vector<HTTPHeader*>::iterator header = _headers->begin(); header != _headers->end(); ++header) {
-    if ((*header)->_name.compare(name)==0) {
-      return ((*header)->_value);
+/**
+ * Returns the name of a well-known header
+ */
+HTTPSpan HTTPHeaders::getName(HTTPHeaderId id) {
+  return id < HEADER_UNKNOWN ? HTTPSpan(WELL_KNOWN_NAMES[id]) : HTTPSpan();
+}
+
+/**
+ * Returns the id of a well-known header, or HEADER_UNKNOWN
+ */
+HTTPHeaderId HTTPHeaders::identify(HTTPSpan const &name) {
+  HTTPHeaderId id;
+  switch(hashName(name)) {
+    case headerHash("host"):                     id = HEADER_HOST; break;
+    case headerHash("connection"):               id = HEADER_CONNECTION; break;
+    case headerHash("content-length"):           id = HEADER_CONTENT_LENGTH; break;
+    case headerHash("content-type"):             id = HEADER_CONTENT_TYPE; break;
+    case headerHash("transfer-encoding"):        id = HEADER_TRANSFER_ENCODING; break;
+    case headerHash("upgrade"):                  id = HEADER_UPGRADE; break;
+    case headerHash("sec-websocket-key"):        id = HEADER_SEC_WEBSOCKET_KEY; break;
+    case headerHash("sec-websocket-version"):    id = HEADER_SEC_WEBSOCKET_VERSION; break;
+    case headerHash("sec-websocket-protocol"):   id = HEADER_SEC_WEBSOCKET_PROTOCOL; break;
+    case headerHash("sec-websocket-extensions"): id = HEADER_SEC_WEBSOCKET_EXTENSIONS; break;
+    case headerHash("sec-websocket-accept"):     id = HEADER_SEC_WEBSOCKET_ACCEPT; break;
+    case headerHash("accept-encoding"):          id = HEADER_ACCEPT_ENCODING; break;
+    case headerHash("authorization"):            id = HEADER_AUTHORIZATION; break;
+    case headerHash("if-none-match"):            id = HEADER_IF_NONE_MATCH; break;
+    case headerHash("range"):                    id = HEADER_RANGE; break;
+    default:
+      return HEADER_UNKNOWN;
+  }
+  // The hash may belong to another name as well
+  return name.equalsIgnoreCase(WELL_KNOWN_NAMES[id]) ? id : HEADER_UNKNOWN;
+}
+
+uint32_t HTTPHeaders::hashName(HTTPSpan const &name) {
+  uint32_t hash = HEADER_HASH_BASIS;
+  const char * data = name.data();
+  for(size_t i = 0; i < name.length(); i++) {
+    char c = data[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    hash = (hash ^ (uint8_t)c) * HEADER_HASH_PRIME;
+  }
+  return hash;
+}
+
+int HTTPHeaders::find(HTTPSpan const &name, uint32_t hash, HTTPHeaderId id) {
+  if (id != HEADER_UNKNOWN) {
+    return _wellKnown[id];
+  }
+  for(size_t i = 0; i < _entries.size(); i++) {
+    if (_entries[i].hash == hash && _entries[i].name.equalsIgnoreCase(name)) {
+      return i;
     }
   }
-  return "";
+  return -1;
 }
 
+/**
+ * Adds a header or replaces the value of the header with the same name
+ */
+void HTTPHeaders::store(HTTPSpan const &name, uint32_t hash, HTTPHeaderId id, HTTPSpan const &value, bool copy) {
+  // Copy first, the value may refer to the entry that is replaced. The name is taken from the
+  // call, as it defines the case that is used for the response.
+  HTTPSpan newName = copy ? copySpan(name) : name;
+  HTTPSpan newValue = copy ? copySpan(value) : value;
+  _isSerialized = false;
 
-void HTTPHeaders::set(HTTPHeader * header) {
-  for(int i = 0; i < _headers->size(); i++) {
-    if ((*_headers)[i]->_name.compare(header->_name)==0) {
-      delete (*_headers)[i];
-      (*_headers)[i] = header;
-      return;
+  int idx = find(name, hash, id);
+  if (idx < 0) {
+    HeaderEntry entry;
+    entry.hash = hash;
+    entry.id = id;
+    entry.owned = false;
+    entry.header = NULL;
+    _entries.push_back(entry);
+    idx = _entries.size() - 1;
+    if (id != HEADER_UNKNOWN) {
+      _wellKnown[id] = idx;
     }
+  } else {
+    releaseEntry(_entries[idx]);
   }
-  _headers->push_back(header);
+
+  HeaderEntry &entry = _entries[idx];
+  entry.owned = copy;
+  entry.name = newName;
+  entry.value = newValue;
 }
 
-std::vector<HTTPHeader *> * HTTPHeaders::getAll() {
-  return _headers;
+/**
+ * Copies the characters of the span into memory that is owned by this object
+ */
+HTTPSpan HTTPHeaders::copySpan(HTTPSpan const &span) {
+  char * data = _arena != NULL ? (char*)_arena->allocate(span.length()) : new char[span.length()];
+  memcpy(data, span.data(), span.length());
+  return HTTPSpan(data, span.length());
 }
 
 /**
- * Deletes all headers
+ * Frees the memory of an entry that has been allocated on the heap. Arena memory is released by
+ * resetting the arena.
  */
-void HTTPHeaders::clearAll() {
-  for(std::vector<HTTPHeader*>::iterator header = _headers->begin(); header != _headers->end(); ++header) {
-    delete (*header);
+void HTTPHeaders::releaseEntry(HeaderEntry &entry) {
+  if (_arena == NULL) {
+    if (entry.owned) {
+      delete[] entry.name.data();
+      delete[] entry.value.data();
+    }
+    delete entry.header;
+  }
+  entry.owned = false;
+  entry.header = NULL;
+}
+
+/**
+ * Returns the HTTPHeader instance for an entry, creating it if required
+ */
+HTTPHeader * HTTPHeaders::materialize(HeaderEntry &entry) {
+  if (entry.header == NULL) {
+    entry.header = _arena != NULL ?
+      _arena->create<HTTPHeader>(entry.name.str(), entry.value.str()) :
+      new HTTPHeader(entry.name.str(), entry.value.str());
   }
-  _headers->clear();
+  return entry.header;
 }
 
 } /* namespace httpsserver */
@@ -9,27 +9,109 @@
 
 #include "HTTPSServerConstants.hpp"
 #include "HTTPHeader.hpp"
+#include "HTTPSpan.hpp"
+#include "RequestArena.hpp"
 
 namespace httpsserver {
 
 /**
- * \brief Groups and manages a set of HTTPHeader instances
+ * Headers that are recognized when they are added to HTTPHeaders, so that they can be looked up
+ * without searching for their name
+ */
+enum HTTPHeaderId {
+  HEADER_HOST,
+  HEADER_CONNECTION,
+  HEADER_CONTENT_LENGTH,
+  HEADER_CONTENT_TYPE,
+  HEADER_TRANSFER_ENCODING,
+  HEADER_UPGRADE,
+  HEADER_SEC_WEBSOCKET_KEY,
+  HEADER_SEC_WEBSOCKET_VERSION,
+  HEADER_SEC_WEBSOCKET_PROTOCOL,
+  HEADER_SEC_WEBSOCKET_EXTENSIONS,
+  HEADER_SEC_WEBSOCKET_ACCEPT,
+  HEADER_ACCEPT_ENCODING,
+  HEADER_AUTHORIZATION,
+  HEADER_IF_NONE_MATCH,
+  HEADER_RANGE,
+  /** Any other header. Also the number of well-known headers. */
+  HEADER_UNKNOWN
+};
+
+/**
+ * \brief Groups and manages a set of HTTP headers
+ *
+ * The headers are kept in a flat table. Names are compared case-insensitively, each entry stores a
+ * hash of its case-folded name, and well-known headers (see HTTPHeaderId) are identified once when
+ * they are added, so they can be accessed by their id in constant time.
+ *
+ * Headers that are parsed from a request are only stored as references into the parser's buffer
+ * (see setSpan()). HTTPHeader instances are only created if they are requested through get() or
+ * getAll().
+ *
+ * If the headers belong to a request, they are stored in the connection's RequestArena. They are
+ * then only valid until the arena is reset, and clearAll() has to be called before the reset.
  */
 class HTTPHeaders {
 public:
-  HTTPHeaders();
+  HTTPHeaders(RequestArena * arena = NULL);
   virtual ~HTTPHeaders();
 
   HTTPHeader * get(std::string const &name);
   std::string getValue(std::string const &name);
+  HTTPSpan getValueSpan(HTTPSpan const &name);
+  HTTPSpan getValueSpan(HTTPHeaderId id);
   void set(HTTPHeader * header);
+  void set(HTTPSpan const &name, HTTPSpan const &value);
+  void set(HTTPHeaderId id, HTTPSpan const &value);
+  void setSpan(HTTPSpan const &name, HTTPSpan const &value);
+  void reserve(size_t count);
 
+  size_t getCount();
+  HTTPSpan getNameAt(size_t idx);
+  HTTPSpan getValueAt(size_t idx);
   std::vector<HTTPHeader *> * getAll();
 
+  void serialize();
+  HTTPSpan getSerialized();
+
   void clearAll();
 
+  static HTTPSpan getName(HTTPHeaderId id);
+  static HTTPHeaderId identify(HTTPSpan const &name);
+
 private:
-  std::vector<HTTPHeader*> * _headers;
+  /** Entry of the header table */
+  struct HeaderEntry {
+    // Hash of the case-folded name
+    uint32_t hash;
+    HTTPHeaderId id;
+    // True if name and value have been copied by set(), false if they refer to the parser's buffer
+    bool owned;
+    HTTPSpan name;
+    HTTPSpan value;
+    // Created on demand by get() and getAll()
+    HTTPHeader * header;
+  };
+
+  static uint32_t hashName(HTTPSpan const &name);
+
+  int find(HTTPSpan const &name, uint32_t hash, HTTPHeaderId id);
+  void store(HTTPSpan const &name, uint32_t hash, HTTPHeaderId id, HTTPSpan const &value, bool copy);
+  HTTPSpan copySpan(HTTPSpan const &span);
+  void releaseEntry(HeaderEntry &entry);
+  HTTPHeader * materialize(HeaderEntry &entry);
+
+  // Arena that holds the headers, NULL if they are allocated on the heap
+  RequestArena * _arena;
+  std::vector<HeaderEntry, ArenaAllocator<HeaderEntry> > _entries;
+  // Index of each well-known header in _entries, or -1
+  int16_t _wellKnown[HEADER_UNKNOWN];
+  // Returned by getAll(). It is rarely used, so it is kept on the heap instead of in the arena.
+  std::vector<HTTPHeader *> _headers;
+  // The headers as they are sent, created by serialize()
+  std::string _serialized;
+  bool _isSerialized;
 };
 
 } /* namespace httpsserver */
@@ -0,0 +1,68 @@
+#include "HTTPMethod.hpp"
+
+namespace httpsserver {
+
+// Names of the methods, in the order of their bits in HTTPMethodId
+static const char * const METHOD_NAMES[] = {
+  "GET",
+  "HEAD",
+  "POST",
+  "PUT",
+  "DELETE",
+  "CONNECT",
+  "OPTIONS",
+  "TRACE",
+  "PATCH"
+};
+
+#define METHOD_COUNT (sizeof(METHOD_NAMES) / sizeof(METHOD_NAMES[0]))
+
+HTTPMethodId parseMethod(HTTPSpan const &name) {
+  // The first character and the length are enough to select the only candidate
+  const char * data = name.data();
+  HTTPMethodId method;
+  switch(name.length()) {
+    case 3:
+      method = data[0] == 'G' ? METHOD_GET : METHOD_PUT;
+      break;
+    case 4:
+      method = data[0] == 'P' ? METHOD_POST : METHOD_HEAD;
+      break;
+    case 5:
+      method = data[0] == 'P' ? METHOD_PATCH : METHOD_TRACE;
+      break;
+    case 6:
+      method = METHOD_DELETE;
+      break;
+    case 7:
+      method = data[0] == 'O' ? METHOD_OPTIONS : METHOD_CONNECT;
+      break;
+    default:
+      return METHOD_UNKNOWN;
+  }
+  return name.equals(getMethodName(method)) ? method : METHOD_UNKNOWN;
+}
+
+const char * getMethodName(HTTPMethodId method) {
+  for(size_t i = 0; i < METHOD_COUNT; i++) {
+    if (method == (1 << i)) {
+      return METHOD_NAMES[i];
+    }
+  }
+  return NULL;
+}
+
+std::string getMethodNames(HTTPMethodMask methods) {
+  std::string names;
+  for(size_t i = 0; i < METHOD_COUNT; i++) {
+    if (methods & (1 << i)) {
+      if (!names.empty()) {
+        names.append(", ");
+      }
+      names.append(METHOD_NAMES[i]);
+    }
+  }
+  return names;
+}
+
+} /* namespace httpsserver */
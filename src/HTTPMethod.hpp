@@ -0,0 +1,57 @@
+#ifndef SRC_HTTPMETHOD_HPP_
+#define SRC_HTTPMETHOD_HPP_
+
+#include <Arduino.h>
+#include <string>
+
+#include "HTTPSpan.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Request methods that are known to the server
+ *
+ * Each method is a single bit, so a set of methods can be stored as HTTPMethodMask, e.g.
+ * METHOD_GET | METHOD_HEAD. Checking whether a node accepts a request is then a single AND.
+ */
+enum HTTPMethodId {
+  /** Any other method. Nodes for such methods are matched by comparing the method's name. */
+  METHOD_UNKNOWN = 0,
+  METHOD_GET     = 0x0001,
+  METHOD_HEAD    = 0x0002,
+  METHOD_POST    = 0x0004,
+  METHOD_PUT     = 0x0008,
+  METHOD_DELETE  = 0x0010,
+  METHOD_CONNECT = 0x0020,
+  METHOD_OPTIONS = 0x0040,
+  METHOD_TRACE   = 0x0080,
+  METHOD_PATCH   = 0x0100,
+  /** All known methods */
+  METHOD_ANY     = 0x01ff
+};
+
+/** A set of HTTPMethodId values */
+typedef uint16_t HTTPMethodMask;
+
+/**
+ * \brief **Utility function**: Returns the id of a method name, or METHOD_UNKNOWN
+ *
+ * Method names are case-sensitive, so "get" is not METHOD_GET.
+ */
+HTTPMethodId parseMethod(HTTPSpan const &name);
+
+/**
+ * \brief **Utility function**: Returns the name of a method, or NULL for METHOD_UNKNOWN and masks
+ */
+const char * getMethodName(HTTPMethodId method);
+
+/**
+ * \brief **Utility function**: Returns the names of all methods in the mask, separated by ", "
+ *
+ * This is the format of the Allow header.
+ */
+std::string getMethodNames(HTTPMethodMask methods);
+
+} /* namespace httpsserver */
+
+#endif /* SRC_HTTPMETHOD_HPP_ */
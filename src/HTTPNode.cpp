@@ -2,10 +2,11 @@
 
 namespace httpsserver {
 
-  HTTPNode::HTTPNode(std::string const &path, const HTTPNodeType nodeType, std::string const &tag):
+  HTTPNode::HTTPNode(std::string const &path, const HTTPNodeType nodeType, std::string const &tag, const HTTPMethodMask methods):
     _path(path),
     _tag(tag),
-    _nodeType(nodeType) {
+    _nodeType(nodeType),
+    _methods(methods) {
 
     // Create vector for valdiators
     _validators = new std::vector<HTTPValidator*>();
@@ -7,6 +7,7 @@
 #undef max
 #include <vector>
 #include "HTTPValidator.hpp"
+#include "HTTPMethod.hpp"
 
 namespace httpsserver {
 
@@ -25,7 +26,7 @@ enum HTTPNodeType {
  */
 class HTTPNode {
 public:
-  HTTPNode(const std::string &path, const HTTPNodeType nodeType, const std::string &tag = "");
+  HTTPNode(const std::string &path, const HTTPNodeType nodeType, const std::string &tag = "", const HTTPMethodMask methods = METHOD_ANY);
   virtual ~HTTPNode();
 
   /**
@@ -43,6 +44,12 @@ public:
   /** Stores the type of the node (as we have not runtime type information by default) */
   const HTTPNodeType _nodeType;
 
+  /**
+   * The methods that the node accepts (see HTTPMethodId). 0 if the node has been created for a
+   * method that the server does not know, see ResourceNode::_method.
+   */
+  const HTTPMethodMask _methods;
+
   bool hasUrlParameter();
   uint8_t getUrlParamCount();
   size_t getParamIdx(uint8_t);
@@ -1,4 +1,5 @@
 #include "HTTPRequest.hpp"
+#include "StaticRoute.hpp"
 
 namespace httpsserver {
 
@@ -6,27 +7,80 @@ HTTPRequest::HTTPRequest(
     ConnectionContext * con,
     HTTPHeaders * headers,
     HTTPNode * resolvedNode,
-    std::string method,
+    const StaticRoute * staticRoute,
+    HTTPSpan const &method,
+    HTTPMethodId methodId,
     ResourceParameters * params,
-    std::string requestString):
+    HTTPSpan const &requestString):
   _con(con),
   _headers(headers),
   _resolvedNode(resolvedNode),
+  _staticRoute(staticRoute),
   _method(method),
+  _methodId(methodId),
   _params(params),
   _requestString(requestString) {
 
-  HTTPHeader * contentLength = headers->get("Content-Length");
-  if (contentLength == NULL) {
+  _isChunked = false;
+  _chunkSizeFound = false;
+  _chunkState = CHUNK_SIZE;
+
+  // If chunked is the last transfer coding, it determines the length of the body. The client
+  // could send Content-Length along with it, but it must be ignored (RFC 7230, 3.3.3).
+  HTTPSpan transferEncoding = headers->getValueSpan(HEADER_TRANSFER_ENCODING);
+  HTTPSpan contentLength = headers->getValueSpan(HEADER_CONTENT_LENGTH);
+  if (transferEncoding.data() != NULL) {
+    _isChunked = isChunkedLast(transferEncoding);
     _remainingContent = 0;
-    _contentLengthSet = false;
+    // Any other transfer coding is rejected by the connection (see hasValidTransferEncoding()).
+    // Should such a request get here anyway, its body is not read at all.
+    _contentLengthSet = !_isChunked;
+  } else if (contentLength.data() != NULL) {
+    _remainingContent = parseInt(contentLength.str());
+    _contentLengthSet = true;
   } else {
-    _remainingContent = parseInt(contentLength->_value);
+    // Without Content-Length and Transfer-Encoding, the request has no body (RFC 7230, 3.3.3).
+    // We must not read any further, as the buffer may already contain the next request.
+    _remainingContent = 0;
     _contentLengthSet = true;
   }
 
 }
 
+/**
+ * Returns false if the request has a Transfer-Encoding header whose last coding is not chunked. The
+ * length of such a body cannot be determined, and guessing it would let the client smuggle data
+ * into the next request on the connection. The request has to be answered with 400 and the
+ * connection has to be closed (RFC 7230, 3.3.3).
+ */
+bool HTTPRequest::hasValidTransferEncoding(HTTPHeaders * headers) {
+  HTTPSpan transferEncoding = headers->getValueSpan(HEADER_TRANSFER_ENCODING);
+  return transferEncoding.data() == NULL || isChunkedLast(transferEncoding);
+}
+
+/**
+ * Checks whether chunked is the last coding in the value of a Transfer-Encoding header, e.g.
+ * "gzip, chunked"
+ */
+bool HTTPRequest::isChunkedLast(HTTPSpan const &transferEncoding) {
+  const char * start = transferEncoding.data();
+  const char * end = start + transferEncoding.length();
+  for(const char * c = end; c > start; c--) {
+    if (c[-1] == ',') {
+      start = c;
+      break;
+    }
+  }
+  // Skip optional whitespace around the coding
+  while(start < end && (*start == ' ' || *start == '\t')) {
+    start++;
+  }
+  while(end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+    end--;
+  }
+  return HTTPSpan(start, end - start).equalsIgnoreCase("chunked");
+}
+
 HTTPRequest::~HTTPRequest() {
   _headers->clearAll();
 }
@@ -37,24 +91,34 @@ ResourceParameters * HTTPRequest::getParams() {
 }
 
 std::string HTTPRequest::getHeader(std::string const &name) {
-  HTTPHeader * h = _headers->get(name);
-  if (h != NULL) {
-    return h->_value;
-  } else {
-    return std::string();
-  }
+  return _headers->getValue(name);
 }
 
 void HTTPRequest::setHeader(std::string const &name, std::string const &value) {
-  _headers->set(new HTTPHeader(name, value));
+  _headers->set(name, value);
 }
 
+/**
+ * Returns the node that handles the request, or NULL if the request is handled by a StaticRoute
+ */
 HTTPNode * HTTPRequest::getResolvedNode() {
   return _resolvedNode;
 }
 
+/**
+ * Returns the StaticRoute that handles the request, or NULL if it is handled by a node
+ */
+const StaticRoute * HTTPRequest::getStaticRoute() {
+  return _staticRoute;
+}
+
 size_t HTTPRequest::readBytes(byte * buffer, size_t length) {
 
+  // Chunked bodies are decoded on the fly
+  if (_isChunked) {
+    return readChunked(buffer, length);
+  }
+
   // Limit reading to content length
   if (_contentLengthSet && length > _remainingContent) {
     length = _remainingContent;
@@ -76,26 +140,45 @@ size_t HTTPRequest::readChars(char * buffer, size_t length) {
   return readBytes((byte*)buffer, length);
 }
 
+/**
+ * Returns the number of body bytes that have not been read yet, as announced by Content-Length.
+ *
+ * Returns 0 for a body with chunked transfer encoding, as its length is not known in advance. Use
+ * requestComplete() to find the end of such a body.
+ */
 size_t HTTPRequest::getContentLength() {
-  return _remainingContent;
+  return _isChunked ? 0 : _remainingContent;
 }
 
 std::string HTTPRequest::getRequestString() {
-  return _requestString;
+  return _requestString.str();
 }
 
 std::string HTTPRequest::getMethod() {
-  return _method;
+  return _method.str();
+}
+
+/**
+ * Returns the method as HTTPMethodId, or METHOD_UNKNOWN if the server does not know the method
+ */
+HTTPMethodId HTTPRequest::getMethodId() {
+  return _methodId;
 }
 
 std::string HTTPRequest::getTag() {
-  return _resolvedNode->_tag;
+  return _resolvedNode != NULL ? _resolvedNode->_tag : std::string(_staticRoute->_tag);
 }
 
 bool HTTPRequest::requestComplete() {
-  if (_contentLengthSet) {
-    // If we have a content size, rely on it.
-    return (_remainingContent == 0);
+  if (_isChunked) {
+    // Check for new data, the rest of the body might be the terminating chunk
+    if (_chunkState != CHUNK_DATA) {
+      parseChunkFraming();
+    }
+    return _chunkState == CHUNK_DONE || _con->isInputClosed();
+  } else if (_contentLengthSet) {
+    // If we have a content size, rely on it. If the connection is gone, the rest won't arrive anymore.
+    return (_remainingContent == 0 || _con->isInputClosed());
   } else {
     // If there is no more input...
     return (_con->pendingBufferSize() == 0);
@@ -106,12 +189,159 @@ bool HTTPRequest::requestComplete() {
  * This function will drop whatever is remaining of the request body
  */
 void HTTPRequest::discardRequestBody() {
-  byte buf[16];
+  if (_isChunked) {
+    while(!requestComplete()) {
+      readChunked(NULL, (size_t)-1);
+    }
+    return;
+  }
   while(!requestComplete()) {
-    readBytes(buf, 16);
+    // Drop the data directly from the connection's buffer, there's no need to copy it
+    byte * data;
+    size_t length = _con->peekBuffer(&data);
+    if (_contentLengthSet && length > _remainingContent) {
+      length = _remainingContent;
+    }
+    _con->consumeBuffer(length);
+    if (_contentLengthSet) {
+      _remainingContent -= length;
+    }
   }
 }
 
+/**
+ * Reads up to length bytes of a chunked body. The data is copied from the connection's buffer to
+ * the target buffer directly, the chunk framing is dropped on the way. If buffer is NULL, the data
+ * is discarded.
+ */
+size_t HTTPRequest::readChunked(byte * buffer, size_t length) {
+  size_t bytesRead = 0;
+  while(bytesRead < length && _chunkState != CHUNK_DONE) {
+    if (_chunkState != CHUNK_DATA) {
+      parseChunkFraming();
+      if (_chunkState != CHUNK_DATA) {
+        // Either the body is complete or we have to wait for more data
+        break;
+      }
+    }
+
+    size_t chunkLength = length - bytesRead;
+    if (chunkLength > _remainingContent) {
+      chunkLength = _remainingContent;
+    }
+    size_t chunkRead;
+    if (buffer != NULL) {
+      chunkRead = _con->readBuffer(buffer + bytesRead, chunkLength);
+    } else {
+      byte * data;
+      chunkRead = _con->peekBuffer(&data);
+      if (chunkRead > chunkLength) {
+        chunkRead = chunkLength;
+      }
+      _con->consumeBuffer(chunkRead);
+    }
+    if (chunkRead == 0) {
+      break;
+    }
+
+    bytesRead += chunkRead;
+    _remainingContent -= chunkRead;
+    if (_remainingContent == 0) {
+      _chunkState = CHUNK_DATA_END;
+    }
+  }
+  return bytesRead;
+}
+
+/**
+ * Processes the chunk framing (size lines, line breaks after the data and trailers) that is
+ * available in the connection's buffer, until chunk data or the end of the body is reached.
+ */
+void HTTPRequest::parseChunkFraming() {
+  byte * data;
+  size_t length = _con->peekBuffer(&data);
+  size_t i = 0;
+  while(i < length && _chunkState != CHUNK_DATA && _chunkState != CHUNK_DONE) {
+    char c = data[i++];
+    switch(_chunkState) {
+    case CHUNK_SIZE:
+      {
+        int digit = -1;
+        if (c >= '0' && c <= '9') {
+          digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+          digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+          digit = c - 'A' + 10;
+        }
+        if (digit >= 0) {
+          if (_remainingContent > ((size_t)-1) >> 4) {
+            HTTPS_LOGW("Chunk size is too large");
+            chunkError();
+            return;
+          }
+          _remainingContent = (_remainingContent << 4) | digit;
+          _chunkSizeFound = true;
+          break;
+        } else if (c != ';' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+          HTTPS_LOGW("Invalid character in chunk size");
+          chunkError();
+          return;
+        }
+        _chunkState = CHUNK_EXTENSION;
+      }
+      // The size line ends here or has extensions, which we ignore
+      // fall through
+    case CHUNK_EXTENSION:
+      if (c == '\n') {
+        if (!_chunkSizeFound) {
+          HTTPS_LOGW("Missing chunk size");
+          chunkError();
+          return;
+        }
+        // The last chunk has a size of zero and may be followed by trailers
+        _chunkState = _remainingContent > 0 ? CHUNK_DATA : CHUNK_TRAILER_START;
+      }
+      break;
+    case CHUNK_DATA_END:
+      if (c == '\n') {
+        _chunkState = CHUNK_SIZE;
+        _chunkSizeFound = false;
+      } else if (c != '\r') {
+        HTTPS_LOGW("Missing line break after chunk data");
+        chunkError();
+        return;
+      }
+      break;
+    case CHUNK_TRAILER_START:
+      if (c == '\n') {
+        _chunkState = CHUNK_DONE;
+      } else if (c != '\r') {
+        _chunkState = CHUNK_TRAILER;
+      }
+      break;
+    case CHUNK_TRAILER:
+      if (c == '\n') {
+        _chunkState = CHUNK_TRAILER_START;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  _con->consumeBuffer(i);
+}
+
+/**
+ * Aborts the request because of an invalid chunked body. The client is answered with 400 and the
+ * connection is closed, as the end of the body cannot be found anymore.
+ */
+void HTTPRequest::chunkError() {
+  _chunkState = CHUNK_DONE;
+  _remainingContent = 0;
+  _con->signalClientError();
+}
+
 std::string HTTPRequest::getBasicAuthUser() {
   std::string token = decodeBasicAuthToken();
   size_t splitpoint = token.find(":");
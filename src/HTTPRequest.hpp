@@ -10,24 +10,36 @@
 #include "HTTPNode.hpp"
 #include "HTTPHeader.hpp"
 #include "HTTPHeaders.hpp"
+#include "HTTPMethod.hpp"
+#include "HTTPSpan.hpp"
 #include "ResourceParameters.hpp"
 #include "util.hpp"
 
 namespace httpsserver {
 
+// StaticRoute.hpp includes the handler function type, which depends on this class
+struct StaticRoute;
+
 /**
  * \brief Represents the request stream for an HTTP request
  */
 class HTTPRequest {
 public:
-  HTTPRequest(ConnectionContext * con, HTTPHeaders * headers, HTTPNode * resolvedNode, std::string method, ResourceParameters * params, std::string requestString);
+  HTTPRequest(ConnectionContext * con, HTTPHeaders * headers, HTTPNode * resolvedNode, const StaticRoute * staticRoute, HTTPSpan const &method, HTTPMethodId methodId, ResourceParameters * params, HTTPSpan const &requestString);
   virtual ~HTTPRequest();
 
   std::string getHeader(std::string const &name);
   void setHeader(std::string const &name, std::string const &value);
+  /**
+   * Returns the node that handles the request. Requests that are handled by a StaticRoute have no
+   * node, so this returns NULL for them. Middleware that may run for static routes has to check
+   * for NULL, or use getStaticRoute() and getTag() instead.
+   */
   HTTPNode * getResolvedNode();
+  const StaticRoute * getStaticRoute();
   std::string getRequestString();
   std::string getMethod();
+  HTTPMethodId getMethodId();
   std::string getTag();
 
   size_t readChars(char * buffer, size_t length);
@@ -41,8 +53,14 @@ public:
   bool   isSecure();
   void setWebsocketHandler(WebsocketHandler *wsHandler);
 
+  static bool hasValidTransferEncoding(HTTPHeaders * headers);
+
 private:
   std::string decodeBasicAuthToken();
+  static bool isChunkedLast(HTTPSpan const &transferEncoding);
+  size_t readChunked(byte * buffer, size_t length);
+  void parseChunkFraming();
+  void chunkError();
 
   ConnectionContext * _con;
 
@@ -50,14 +68,42 @@ private:
 
   HTTPNode * _resolvedNode;
 
-  std::string _method;
+  // Set instead of _resolvedNode if the request matched a StaticRoute
+  const StaticRoute * _staticRoute;
+
+  // Method and request string are owned by the connection and only copied if requested
+  HTTPSpan _method;
+  HTTPMethodId _methodId;
 
   ResourceParameters * _params;
 
-  std::string _requestString;
+  HTTPSpan _requestString;
 
   bool _contentLengthSet;
+  // Remaining bytes of the body, or of the current chunk if the body uses chunked transfer encoding
   size_t _remainingContent;
+
+  // Is the request body sent with chunked transfer encoding?
+  bool _isChunked;
+  // Does the size line of the current chunk contain a (hex) digit?
+  bool _chunkSizeFound;
+  // Position in the chunked body
+  enum {
+    // Reading the size of the next chunk
+    CHUNK_SIZE,
+    // Skipping the chunk extensions until the end of the size line
+    CHUNK_EXTENSION,
+    // Reading the chunk data, _remainingContent bytes are left
+    CHUNK_DATA,
+    // Expecting the line break after the chunk data
+    CHUNK_DATA_END,
+    // At the start of a trailer line (an empty line ends the body)
+    CHUNK_TRAILER_START,
+    // Skipping a trailer line
+    CHUNK_TRAILER,
+    // The body has been read completely
+    CHUNK_DONE
+  } _chunkState;
 };
 
 } /* namespace httpsserver */
@@ -3,22 +3,85 @@
 #include <Arduino.h>
 #include "lwip/sockets.h"
 
+#include "ResourceParameters.hpp"
+
 namespace httpsserver {
 
+// Preformatted status lines for the common status codes with their default status text
+#define STATUS_LINE(code, text) { code, "HTTP/1.1 " #code " " text "\r\n", sizeof("HTTP/1.1 " #code " " text "\r\n") - 1 }
+static const struct {
+  uint16_t code;
+  const char * line;
+  size_t length;
+} STATUS_LINES[] = {
+  STATUS_LINE(100, "Continue"),
+  STATUS_LINE(101, "Switching Protocols"),
+  STATUS_LINE(200, "OK"),
+  STATUS_LINE(201, "Created"),
+  STATUS_LINE(202, "Accepted"),
+  STATUS_LINE(204, "No Content"),
+  STATUS_LINE(206, "Partial Content"),
+  STATUS_LINE(301, "Moved Permanently"),
+  STATUS_LINE(302, "Found"),
+  STATUS_LINE(303, "See Other"),
+  STATUS_LINE(304, "Not Modified"),
+  STATUS_LINE(307, "Temporary Redirect"),
+  STATUS_LINE(308, "Permanent Redirect"),
+  STATUS_LINE(400, "Bad Request"),
+  STATUS_LINE(401, "Unauthorized"),
+  STATUS_LINE(403, "Forbidden"),
+  STATUS_LINE(404, "Not Found"),
+  STATUS_LINE(405, "Method Not Allowed"),
+  STATUS_LINE(406, "Not Acceptable"),
+  STATUS_LINE(408, "Request Timeout"),
+  STATUS_LINE(409, "Conflict"),
+  STATUS_LINE(410, "Gone"),
+  STATUS_LINE(411, "Length Required"),
+  STATUS_LINE(412, "Precondition Failed"),
+  STATUS_LINE(413, "Payload Too Large"),
+  STATUS_LINE(414, "URI Too Long"),
+  STATUS_LINE(415, "Unsupported Media Type"),
+  STATUS_LINE(416, "Range Not Satisfiable"),
+  STATUS_LINE(417, "Expectation Failed"),
+  STATUS_LINE(426, "Upgrade Required"),
+  STATUS_LINE(429, "Too Many Requests"),
+  STATUS_LINE(431, "Request Header Fields Too Large"),
+  STATUS_LINE(500, "Internal Server Error"),
+  STATUS_LINE(501, "Not Implemented"),
+  STATUS_LINE(502, "Bad Gateway"),
+  STATUS_LINE(503, "Service Unavailable"),
+  STATUS_LINE(504, "Gateway Timeout"),
+  STATUS_LINE(505, "HTTP Version Not Supported")
+};
+#undef STATUS_LINE
+
+// Length of "HTTP/1.1 200 " in the lines above
+#define STATUS_LINE_PREFIX_LENGTH 13
+
 HTTPResponse::HTTPResponse(ConnectionContext * con):
-  _con(con) {
+  _con(con),
+  _headers(con->getArena()) {
 
   // Default status code is 200 OK
   _statusCode = 200;
   _statusText = "OK";
+  _defaultHeaders = NULL;
   _headerWritten = false;
   _isError = false;
+  _isChunked = false;
+  _isLengthDelimited = false;
+  _remainingLength = 0;
+  _isBodyOmitted = false;
+  // Room for the headers of a typical response (content type, content length, connection and one
+  // more), so the table is not copied while it grows
+  _headers.reserve(4);
 
   _responseCacheSize = con->getCacheSize();
   _responseCachePointer = 0;
   if (_responseCacheSize > 0) {
     HTTPS_LOGD("Creating buffered response, size: %d", _responseCacheSize);
-    _responseCache = new byte[_responseCacheSize];
+    // The cache is released with the rest of the request when the connection resets its arena
+    _responseCache = (byte*)con->getArena()->allocate(_responseCacheSize);
   } else {
     HTTPS_LOGD("Creating non-buffered response");
     _responseCache = NULL;
@@ -26,9 +89,6 @@ HTTPResponse::HTTPResponse(ConnectionContext * con):
 }
 
 HTTPResponse::~HTTPResponse() {
-  if (_responseCache != NULL) {
-    delete[] _responseCache;
-  }
   _headers.clearAll();
 }
 
@@ -49,7 +109,24 @@ std::string HTTPResponse::getStatusText() {
 }
 
 void HTTPResponse::setHeader(std::string const &name, std::string const &value) {
-  _headers.set(new HTTPHeader(name, value));
+  _headers.set(name, value);
+}
+
+/**
+ * Sets the headers that are sent along with the headers of this response. A header that is also
+ * set with setHeader() is only sent once, with the value of setHeader().
+ */
+void HTTPResponse::setDefaultHeaders(HTTPHeaders * defaultHeaders) {
+  _defaultHeaders = defaultHeaders;
+}
+
+/**
+ * Drops the body that is written to the response, but sends the headers as usual. Used for HEAD
+ * requests, so that they can be handled by the handler for GET. A buffered response still counts the
+ * bytes for its Content-Length header.
+ */
+void HTTPResponse::omitBody() {
+  _isBodyOmitted = true;
 }
 
 bool HTTPResponse::isHeaderWritten() {
@@ -60,9 +137,40 @@ bool HTTPResponse::isResponseBuffered() {
   return _responseCache != NULL;
 }
 
+/**
+ * Returns true if the response did not fit into the cache and is sent with chunked transfer encoding
+ */
+bool HTTPResponse::isResponseChunked() {
+  return _isChunked;
+}
+
+/**
+ * Returns true if the response did not fit into the cache and has been streamed with the
+ * Content-Length that the handler has set, and if exactly that many bytes have been written. Only
+ * then can the client find the end of the response without closing the connection.
+ */
+bool HTTPResponse::isResponseLengthDelimited() {
+  return _isLengthDelimited && _remainingLength == 0;
+}
+
 void HTTPResponse::finalize() {
   if (isResponseBuffered()) {
     drainBuffer();
+  } else if (_isChunked) {
+    // The last chunk has a size of zero and no data
+    printInternal("0\r\n\r\n", true);
+  }
+}
+
+/**
+ * Sends the data that has been written so far to the client.
+ *
+ * Has no effect on buffered (keep-alive) responses, as their length is only known after the handler
+ * has returned.
+ */
+void HTTPResponse::flush() {
+  if (!isResponseBuffered()) {
+    _con->flushBuffer();
   }
 }
 
@@ -102,20 +210,79 @@ void HTTPResponse::printHeader() {
     HTTPS_LOGD("Printing headers");
 
     // Status line, like: "HTTP/1.1 200 OK\r\n"
-    std::string statusLine = "HTTP/1.1 " + intToString(_statusCode) + " " + _statusText + "\r\n";
-    printInternal(statusLine, true);
+    printStatusLine();
+
+    // Default headers of the server
+    if (_defaultHeaders != NULL) {
+      printDefaultHeaders();
+    }
 
     // Each header, like: "Host: myEsp32\r\n"
-    std::vector<HTTPHeader *> * headers = _headers.getAll();
-    for(std::vector<HTTPHeader*>::iterator header = headers->begin(); header != headers->end(); ++header) {
-      printInternal((*header)->print()+"\r\n", true);
+    for(size_t i = 0; i < _headers.getCount(); i++) {
+      HTTPSpan name = _headers.getNameAt(i);
+      HTTPSpan value = _headers.getValueAt(i);
+      writeBytesInternal(name.data(), name.length(), true);
+      writeBytesInternal(": ", 2, true);
+      writeBytesInternal(value.data(), value.length(), true);
+      writeBytesInternal("\r\n", 2, true);
     }
-    printInternal("\r\n", true);
+    writeBytesInternal("\r\n", 2, true);
 
     _headerWritten=true;
   }
 }
 
+/**
+ * Writes the status line. For the common status codes, it is taken from a table.
+ */
+void HTTPResponse::printStatusLine() {
+  for(size_t i = 0; i < sizeof(STATUS_LINES) / sizeof(STATUS_LINES[0]) && STATUS_LINES[i].code <= _statusCode; i++) {
+    if (STATUS_LINES[i].code == _statusCode) {
+      // The line can only be used if the handler did not change the status text
+      size_t textLength = STATUS_LINES[i].length - STATUS_LINE_PREFIX_LENGTH - 2;
+      if (_statusText.compare(0, std::string::npos, STATUS_LINES[i].line + STATUS_LINE_PREFIX_LENGTH, textLength) == 0) {
+        writeBytesInternal(STATUS_LINES[i].line, STATUS_LINES[i].length, true);
+        return;
+      }
+      break;
+    }
+  }
+
+  char prefix[16];
+  int prefixLength = snprintf(prefix, sizeof(prefix), "HTTP/1.1 %u ", (unsigned)_statusCode);
+  writeBytesInternal(prefix, prefixLength, true);
+  writeBytesInternal(_statusText.data(), _statusText.length(), true);
+  writeBytesInternal("\r\n", 2, true);
+}
+
+/**
+ * Writes the default headers that are not overridden by the headers of the response
+ */
+void HTTPResponse::printDefaultHeaders() {
+  bool overridden = false;
+  for(size_t i = 0; i < _headers.getCount() && !overridden; i++) {
+    overridden = _defaultHeaders->getValueSpan(_headers.getNameAt(i)).data() != NULL;
+  }
+
+  // Usually, the block that has been prepared by the server can be copied as it is
+  HTTPSpan block = _defaultHeaders->getSerialized();
+  if (!overridden && block.data() != NULL) {
+    writeBytesInternal(block.data(), block.length(), true);
+    return;
+  }
+
+  for(size_t i = 0; i < _defaultHeaders->getCount(); i++) {
+    HTTPSpan name = _defaultHeaders->getNameAt(i);
+    if (_headers.getValueSpan(name).data() == NULL) {
+      HTTPSpan value = _defaultHeaders->getValueAt(i);
+      writeBytesInternal(name.data(), name.length(), true);
+      writeBytesInternal(": ", 2, true);
+      writeBytesInternal(value.data(), value.length(), true);
+      writeBytesInternal("\r\n", 2, true);
+    }
+  }
+}
+
 /**
  * This method can be called to cancel the ongoing transmission and send the error page (if possible)
  */
@@ -129,6 +296,13 @@ void HTTPResponse::printInternal(const std::string &str, bool skipBuffer) {
 
 size_t HTTPResponse::writeBytesInternal(const void * data, int length, bool skipBuffer) {
   if (!_isError) {
+    if (_isBodyOmitted && !skipBuffer) {
+      if (isResponseBuffered()) {
+        // Only the length is needed, so the cache cannot overflow
+        _responseCachePointer += length;
+      }
+      return length;
+    }
     if (isResponseBuffered() && !skipBuffer) {
       // We are buffering ...
       if(length <= _responseCacheSize - _responseCachePointer) {
@@ -142,14 +316,40 @@ size_t HTTPResponse::writeBytesInternal(const void * data, int length, bool skip
         return length;
       } else {
         // .., and the buffer is too small. This is the point where we switch from
-        // caching to streaming
+        // caching to streaming. If the handler has set Content-Length, the body is streamed as
+        // it is. Otherwise, if the client supports chunked transfer encoding, we use it. Both
+        // allow to keep the connection alive. If neither is possible, the end of the response is
+        // signaled by closing the connection.
         if (!_headerWritten) {
-          setHeader("Connection", "close");
+          HTTPSpan contentLength = _headers.getValueSpan(HEADER_CONTENT_LENGTH);
+          int64_t announced = 0;
+          if (contentLength.data() != NULL) {
+            // Content-Length and Transfer-Encoding must not be sent together (RFC 7230, 3.3.2)
+            if (ResourceParameters::parseInt64(contentLength, announced) && announced >= 0) {
+              setHeader("Connection", "keep-alive");
+              _isLengthDelimited = true;
+              _remainingLength = announced;
+            } else {
+              setHeader("Connection", "close");
+            }
+          } else if (_con->canSendChunked()) {
+            setHeader("Transfer-Encoding", "chunked");
+            setHeader("Connection", "keep-alive");
+            _isChunked = true;
+          } else {
+            setHeader("Connection", "close");
+          }
         }
         drainBuffer(true);
       }
     }
 
+    if (_isChunked && !skipBuffer) {
+      return writeChunk(data, length);
+    }
+    if (_isLengthDelimited && !skipBuffer) {
+      countLengthDelimited(length);
+    }
     return _con->writeBuffer((byte*)data, length);
   } else {
     return 0;
@@ -159,7 +359,7 @@ size_t HTTPResponse::writeBytesInternal(const void * data, int length, bool skip
 void HTTPResponse::drainBuffer(bool onOverflow) {
   if (!_headerWritten) {
     if (_responseCache != NULL && !onOverflow) {
-      _headers.set(new HTTPHeader("Content-Length", intToString(_responseCachePointer)));
+      _headers.set(HEADER_CONTENT_LENGTH, intToString(_responseCachePointer));
     }
     printHeader();
   }
@@ -167,13 +367,49 @@ void HTTPResponse::drainBuffer(bool onOverflow) {
   if (_responseCache != NULL) {
     HTTPS_LOGD("Draining response buffer");
     // Check for 0 as it may be an overflow reaction without any data that has been written earlier
-    if(_responseCachePointer > 0) {
+    if(_responseCachePointer > 0 && !_isBodyOmitted) {
       // FIXME: Return value?
-      _con->writeBuffer((byte*)_responseCache, _responseCachePointer);
+      if (_isChunked) {
+        writeChunk(_responseCache, _responseCachePointer);
+      } else {
+        if (_isLengthDelimited) {
+          countLengthDelimited(_responseCachePointer);
+        }
+        _con->writeBuffer((byte*)_responseCache, _responseCachePointer);
+      }
     }
-    delete[] _responseCache;
     _responseCache = NULL;
   }
 }
 
+/**
+ * Counts bytes of a body that is streamed with the Content-Length of the handler. If the handler
+ * writes more than it has announced, the client would take the rest for the next response, so the
+ * connection has to be closed after the response.
+ */
+void HTTPResponse::countLengthDelimited(size_t length) {
+  if (length > _remainingLength) {
+    HTTPS_LOGW("Response body is longer than its Content-Length, closing the connection");
+    _isLengthDelimited = false;
+  } else {
+    _remainingLength -= length;
+  }
+}
+
+/**
+ * Writes data as a single chunk (size line, data, line break). Empty writes are skipped, as a chunk
+ * without data marks the end of the response.
+ */
+size_t HTTPResponse::writeChunk(const void * data, size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  char sizeLine[12];
+  int sizeLineLength = snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", (unsigned int)length);
+  _con->writeBuffer((byte*)sizeLine, sizeLineLength);
+  size_t written = _con->writeBuffer((byte*)data, length);
+  _con->writeBuffer((byte*)"\r\n", 2);
+  return written;
+}
+
 } /* namespace httpsserver */
@@ -32,6 +32,8 @@ public:
   uint16_t getStatusCode();
   std::string getStatusText();
   void setHeader(std::string const &name, std::string const &value);
+  void setDefaultHeaders(HTTPHeaders * defaultHeaders);
+  void omitBody();
   bool isHeaderWritten();
 
   void printStd(std::string const &str);
@@ -43,21 +45,38 @@ public:
   void error();
 
   bool isResponseBuffered();
+  bool isResponseChunked();
+  bool isResponseLengthDelimited();
   void finalize();
+  void flush();
 
   ConnectionContext * _con;
   
 private:
   void printHeader();
+  void printStatusLine();
+  void printDefaultHeaders();
   void printInternal(const std::string &str, bool skipBuffer = false);
   size_t writeBytesInternal(const void * data, int length, bool skipBuffer = false);
   void drainBuffer(bool onOverflow = false);
+  size_t writeChunk(const void * data, size_t length);
+  void countLengthDelimited(size_t length);
 
   uint16_t _statusCode;
   std::string _statusText;
   HTTPHeaders _headers;
+  // Headers of the server that are sent unless the response sets them itself
+  HTTPHeaders * _defaultHeaders;
   bool _headerWritten;
   bool _isError;
+  // Is the body sent with chunked transfer encoding?
+  bool _isChunked;
+  // Is the body streamed with the Content-Length set by the handler?
+  bool _isLengthDelimited;
+  // Bytes of that Content-Length that have not been written yet
+  size_t _remainingLength;
+  // Is the body dropped (response to a HEAD request)?
+  bool _isBodyOmitted;
 
   // Response cache
   byte * _responseCache;
@@ -3,8 +3,8 @@
 namespace httpsserver {
 
 
-HTTPSConnection::HTTPSConnection(ResourceResolver * resResolver):
-  HTTPConnection(resResolver) {
+HTTPSConnection::HTTPSConnection(ResourceResolver * resResolver, TimerWheel * timerWheel):
+  HTTPConnection(resResolver, timerWheel) {
   _ssl = NULL;
 }
 
@@ -37,13 +37,17 @@ int HTTPSConnection::initialize(int serverSocketID, SSL_CTX * sslCtx, HTTPHeader
         int success = SSL_set_fd(_ssl, resSocket);
         if (success) {
 
-          // Perform the handshake
-          success = SSL_accept(_ssl);
-          if (success) {
+          // The handshake is done step by step in loop(), so that other connections don't have
+          // to wait for it. For that, the socket is non-blocking until the handshake is complete.
+          int flags = fcntl(resSocket, F_GETFL, 0);
+          fcntl(resSocket, F_SETFL, flags | O_NONBLOCK);
+          _connectionState = STATE_HANDSHAKE;
+          setTimeout(HTTPS_HANDSHAKE_TIMEOUT);
+          continueHandshake();
+          if (!isClosed()) {
             return resSocket;
-          } else {
-            HTTPS_LOGE("SSL_accept failed. Aborting handshake. FID=%d", resSocket);
           }
+          return -1;
         } else {
           HTTPS_LOGE("SSL_set_fd failed. Aborting handshake. FID=%d", resSocket);
         }
@@ -67,14 +71,53 @@ int HTTPSConnection::initialize(int serverSocketID, SSL_CTX * sslCtx, HTTPHeader
 }
 
 
+/**
+ * Continues the TLS handshake with the data that is available on the socket.
+ *
+ * When the handshake is complete, the socket is switched back to blocking mode and the connection
+ * can read the request. If it fails or takes longer than HTTPS_HANDSHAKE_TIMEOUT, the connection is closed.
+ */
+void HTTPSConnection::continueHandshake() {
+  // If the client has to send something first and the server knows that nothing has arrived yet,
+  // we can skip the call to SSL_accept()
+  if (_readiness == READINESS_IDLE && SSL_want_read(_ssl)) {
+    return;
+  }
+
+  int ret = SSL_accept(_ssl);
+  if (ret == 1) {
+    int socket = getSocket();
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
+    HTTPS_LOGD("SSL handshake completed. FID=%d", socket);
+    _connectionState = STATE_INITIAL;
+    setTimeout(HTTPS_CONNECTION_TIMEOUT);
+  } else {
+    int err = SSL_get_error(_ssl, ret);
+    if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+      HTTPS_LOGE("SSL_accept failed. Aborting handshake. FID=%d", getSocket());
+      _connectionState = STATE_ERROR;
+      closeConnection();
+    }
+  }
+  _readiness = READINESS_UNKNOWN;
+}
+
 void HTTPSConnection::closeConnection() {
+  // Send what is left in the buffer before the TLS session is shut down
+  if (_ssl) {
+    flushBuffer();
+  }
+
+  // Without a completed handshake, there is no TLS session that could be shut down
+  bool shutdownTLS = _connectionState != STATE_HANDSHAKE;
 
   // FIXME: Copy from HTTPConnection, could be done better probably
   if (_connectionState != STATE_ERROR && _connectionState != STATE_CLOSED) {
 
-    // First call to closeConnection - set the timestamp to calculate the timeout later on
+    // First call to closeConnection - start the shutdown timeout
     if (_connectionState != STATE_CLOSING) {
-      _shutdownTS = millis();
+      setTimeout(HTTPS_SHUTDOWN_TIMEOUT);
     }
 
     // Set the connection state to closing. We stay in closing as long as SSL has not been shutdown
@@ -82,19 +125,13 @@ void HTTPSConnection::closeConnection() {
     _connectionState = STATE_CLOSING;
   }
 
-  // Try to tear down SSL while we are in the _shutdownTS timeout period or if an error occurred
+  // Try to tear down SSL until the shutdown timeout expires (see handleTimeout()) or if an error occurred
   if (_ssl) {
-    if(_connectionState == STATE_ERROR || SSL_shutdown(_ssl) == 0) {
+    if(_connectionState == STATE_ERROR || !shutdownTLS || SSL_shutdown(_ssl) == 0) {
       // SSL_shutdown will return 1 as soon as the client answered with close notify
       // This means we are safe to close the socket
       SSL_free(_ssl);
       _ssl = NULL;
-    } else if (_shutdownTS + HTTPS_SHUTDOWN_TIMEOUT < millis()) {
-      // The timeout has been hit, we force SSL shutdown now by freeing the context
-      SSL_free(_ssl);
-      _ssl = NULL;
-      HTTPS_LOGW("SSL_shutdown did not receive close notification from the client");
-      _connectionState = STATE_ERROR;
     }
   }
 
@@ -104,7 +141,27 @@ void HTTPSConnection::closeConnection() {
   }
 }
 
-size_t HTTPSConnection::writeBuffer(byte* buffer, size_t length) {
+/**
+ * Called by the timer wheel if the handshake, the shutdown or the connection has timed out
+ */
+void HTTPSConnection::handleTimeout() {
+  if (_connectionState == STATE_HANDSHAKE) {
+    HTTPS_LOGW("SSL handshake timed out. FID=%d", getSocket());
+    _connectionState = STATE_ERROR;
+    closeConnection();
+  } else if (_connectionState == STATE_CLOSING && _ssl) {
+    // The client did not send its close notify in time, we force SSL shutdown now by freeing the context
+    SSL_free(_ssl);
+    _ssl = NULL;
+    HTTPS_LOGW("SSL_shutdown did not receive close notification from the client");
+    _connectionState = STATE_ERROR;
+    HTTPConnection::closeConnection();
+  } else {
+    HTTPConnection::handleTimeout();
+  }
+}
+
+size_t HTTPSConnection::sendBytes(byte* buffer, size_t length) {
   return SSL_write(_ssl, buffer, length);
 }
 
@@ -31,7 +31,7 @@ namespace httpsserver {
  */
 class HTTPSConnection : public HTTPConnection {
 public:
-  HTTPSConnection(ResourceResolver * resResolver);
+  HTTPSConnection(ResourceResolver * resResolver, TimerWheel * timerWheel);
   virtual ~HTTPSConnection();
 
   virtual int initialize(int serverSocketID, SSL_CTX * sslCtx, HTTPHeaders *defaultHeaders);
@@ -45,7 +45,9 @@ protected:
   virtual size_t readBytesToBuffer(byte* buffer, size_t length);
   virtual size_t pendingByteCount();
   virtual bool canReadData();
-  virtual size_t writeBuffer(byte* buffer, size_t length);
+  virtual size_t sendBytes(byte* buffer, size_t length);
+  virtual void continueHandshake();
+  virtual void handleTimeout();
 
 private:
   // SSL context for this connection
@@ -3,12 +3,14 @@
 namespace httpsserver {
 
 
-HTTPSServer::HTTPSServer(SSLCert * cert, const uint16_t port, const uint8_t maxConnections, const in_addr_t bindAddress):
-  HTTPServer(port, maxConnections, bindAddress),
+HTTPSServer::HTTPSServer(SSLCert * cert, const uint16_t port, const uint8_t maxConnections, const in_addr_t bindAddress,
+    const uint8_t workerCount):
+  HTTPServer(port, maxConnections, bindAddress, workerCount),
   _cert(cert) {
 
   // Configure runtime data
   _sslctx = NULL;
+  _sessionCacheSize = 0;
 }
 
 HTTPSServer::~HTTPSServer() {
@@ -54,20 +56,33 @@ void HTTPSServer::teardownSocket() {
   _sslctx = NULL;
 }
 
-int HTTPSServer::createConnection(int idx) {
-  HTTPSConnection * newConnection = new HTTPSConnection(this);
-  _connections[idx] = newConnection;
-  return newConnection->initialize(_socket, _sslctx, &_defaultHeaders);
+HTTPConnection * HTTPSServer::createConnection(TimerWheel * timerWheel) {
+  return new HTTPSConnection(this, timerWheel);
+}
+
+int HTTPSServer::initializeConnection(HTTPConnection * connection) {
+  // The pool only contains connections created by createConnection()
+  return static_cast<HTTPSConnection*>(connection)->initialize(_socket, _sslctx, &_defaultHeaders);
 }
 
 /**
  * This method configures the ssl context that is used for the server
  */
 uint8_t HTTPSServer::setupSSLCTX() {
+#ifdef SSL_CTX_set_min_proto_version
+  // OpenSSL 1.1 deprecated the version-specific methods (host build)
+  _sslctx = SSL_CTX_new(TLS_server_method());
+  if (_sslctx) {
+    SSL_CTX_set_min_proto_version(_sslctx, TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(_sslctx, TLS1_2_VERSION);
+  }
+#else
   _sslctx = SSL_CTX_new(TLSv1_2_server_method());
+#endif
   if (_sslctx) {
     // Set SSL Timeout to 5 minutes
     SSL_CTX_set_timeout(_sslctx, 300);
+    setupSessionResumption();
     return 1;
   } else {
     _sslctx = NULL;
@@ -75,6 +90,160 @@ uint8_t HTTPSServer::setupSSLCTX() {
   }
 }
 
+/**
+ * Enables the server-side session cache and session tickets (if supported by the TLS library), so
+ * that reconnecting clients can resume their session instead of doing a full handshake.
+ *
+ * The cache gets HTTPS_SSL_SESSION_CACHE_SIZE entries, or fewer if that many entries of
+ * HTTPS_SSL_SESSION_ENTRY_SIZE bytes would leave less than HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP
+ * bytes of free heap.
+ */
+void HTTPSServer::setupSessionResumption() {
+#ifdef SSL_SESS_CACHE_SERVER
+  uint32_t freeHeap = esp_get_free_heap_size();
+  uint32_t budget = freeHeap > HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP ? freeHeap - HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP : 0;
+  _sessionCacheSize = budget / HTTPS_SSL_SESSION_ENTRY_SIZE;
+  if (_sessionCacheSize > HTTPS_SSL_SESSION_CACHE_SIZE) {
+    _sessionCacheSize = HTTPS_SSL_SESSION_CACHE_SIZE;
+  }
+  if (_sessionCacheSize > 0) {
+    SSL_CTX_set_session_cache_mode(_sslctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(_sslctx, _sessionCacheSize);
+    HTTPS_LOGI("Session cache: %lu entries, up to %lu bytes", _sessionCacheSize,
+      _sessionCacheSize * HTTPS_SSL_SESSION_ENTRY_SIZE);
+  } else {
+    // A cache size of 0 would mean no limit at all
+    SSL_CTX_set_session_cache_mode(_sslctx, SSL_SESS_CACHE_OFF);
+    HTTPS_LOGW("Not enough free heap for the session cache (%u bytes)", (unsigned)freeHeap);
+  }
+#endif
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+  // Start with random keys. The previous key will never match a ticket
+  createTicketKey(_ticketKeys[0]);
+  createTicketKey(_ticketKeys[1]);
+  SSL_CTX_set_app_data(_sslctx, this);
+  SSL_CTX_set_tlsext_ticket_key_cb(_sslctx, &HTTPSServer::ticketKeyCallback);
+#endif
+}
+
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+void HTTPSServer::createTicketKey(TicketKey &key) {
+  RAND_bytes(key.name, sizeof(key.name));
+  RAND_bytes(key.aesKey, sizeof(key.aesKey));
+  RAND_bytes(key.hmacKey, sizeof(key.hmacKey));
+  key.created = millis();
+}
+
+/**
+ * Replaces the ticket key. The current key is kept as previous key to accept the tickets issued with it
+ */
+void HTTPSServer::rotateTicketKeys() {
+  _ticketKeys[1] = _ticketKeys[0];
+  createTicketKey(_ticketKeys[0]);
+  HTTPS_LOGD("Rotated session ticket key");
+}
+
+/**
+ * Called by OpenSSL to encrypt a new session ticket or to decrypt a ticket presented by a client.
+ *
+ * A key is used for new tickets during HTTPS_SSL_TICKET_KEY_LIFETIME and accepted for another
+ * lifetime after that. Keys are rotated on both paths, so tickets expire even if the server does
+ * not issue new ones.
+ *
+ * Returns 1 if the key has been set up, 2 if the ticket is valid but should be renewed (because it
+ * uses the previous key), and 0 if the ticket is unknown or expired (a full handshake is done in
+ * that case).
+ */
+int HTTPSServer::ticketKeyCallback(SSL * ssl, unsigned char keyName[16], unsigned char * iv,
+    EVP_CIPHER_CTX * cipherCtx, HMAC_CTX * hmacCtx, int encrypt) {
+  HTTPSServer * server = (HTTPSServer*)SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+  std::lock_guard<std::mutex> lock(server->_ticketKeyMutex);
+  unsigned long now = millis();
+  if (now - server->_ticketKeys[0].created > HTTPS_SSL_TICKET_KEY_LIFETIME) {
+    server->rotateTicketKeys();
+  }
+  if (encrypt) {
+    TicketKey &key = server->_ticketKeys[0];
+    if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+      return -1;
+    }
+    memcpy(keyName, key.name, sizeof(key.name));
+    EVP_EncryptInit_ex(cipherCtx, EVP_aes_128_cbc(), NULL, key.aesKey, iv);
+    HMAC_Init_ex(hmacCtx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), NULL);
+    return 1;
+  }
+
+  for(int i = 0; i < 2; i++) {
+    TicketKey &key = server->_ticketKeys[i];
+    if (memcmp(keyName, key.name, sizeof(key.name)) == 0) {
+      // The previous key may have been rotated out long ago, if no tickets were processed since then
+      if (now - key.created > 2 * (unsigned long)HTTPS_SSL_TICKET_KEY_LIFETIME) {
+        HTTPS_LOGD("Session ticket expired");
+        return 0;
+      }
+      HMAC_Init_ex(hmacCtx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), NULL);
+      EVP_DecryptInit_ex(cipherCtx, EVP_aes_128_cbc(), NULL, key.aesKey, iv);
+      return i == 0 ? 1 : 2;
+    }
+  }
+  return 0;
+}
+#endif
+
+/**
+ * Returns the number of TLS handshakes that required a full key exchange.
+ *
+ * The statistics are reset when the server is stopped.
+ */
+unsigned long HTTPSServer::getFullHandshakeCount() {
+#ifdef SSL_CTX_sess_hits
+  if (_sslctx == NULL) return 0;
+  return SSL_CTX_sess_accept_good(_sslctx) - SSL_CTX_sess_hits(_sslctx);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Returns the number of TLS handshakes that resumed a session from the cache or from a ticket
+ */
+unsigned long HTTPSServer::getResumedHandshakeCount() {
+#ifdef SSL_CTX_sess_hits
+  if (_sslctx == NULL) return 0;
+  return SSL_CTX_sess_hits(_sslctx);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Returns the number of sessions that are currently held in the session cache
+ */
+unsigned long HTTPSServer::getCachedSessionCount() {
+#ifdef SSL_CTX_sess_hits
+  if (_sslctx == NULL) return 0;
+  return SSL_CTX_sess_number(_sslctx);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Returns the maximum number of sessions in the session cache, as it has been determined from the
+ * free heap when the server was started. 0 if the cache is disabled.
+ */
+unsigned long HTTPSServer::getSessionCacheSize() {
+  return _sessionCacheSize;
+}
+
+/**
+ * Returns the heap that is accounted for the sessions in the session cache (the number of sessions
+ * times HTTPS_SSL_SESSION_ENTRY_SIZE)
+ */
+size_t HTTPSServer::getSessionCacheMemory() {
+  return getCachedSessionCount() * HTTPS_SSL_SESSION_ENTRY_SIZE;
+}
+
 /**
  * This method configures the certificate and private key for the given
  * ssl context
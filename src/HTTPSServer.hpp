@@ -6,10 +6,19 @@
 
 // Arduino stuff
 #include <Arduino.h>
+#include <esp_system.h>
 
 // Required for SSL
 #include "openssl/ssl.h"
 #undef read
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "openssl/rand.h"
+#undef min
+#undef max
+#include <mutex>
+#endif
 
 // Internal includes
 #include "HTTPServer.hpp"
@@ -29,9 +38,17 @@ namespace httpsserver {
  */
 class HTTPSServer : public HTTPServer {
 public:
-  HTTPSServer(SSLCert * cert, const uint16_t portHTTPS = 443, const uint8_t maxConnections = 4, const in_addr_t bindAddress = 0);
+  HTTPSServer(SSLCert * cert, const uint16_t portHTTPS = 443, const uint8_t maxConnections = 4, const in_addr_t bindAddress = 0,
+    const uint8_t workerCount = 1);
   virtual ~HTTPSServer();
 
+  // TLS handshake statistics
+  unsigned long getFullHandshakeCount();
+  unsigned long getResumedHandshakeCount();
+  unsigned long getCachedSessionCount();
+  unsigned long getSessionCacheSize();
+  size_t getSessionCacheMemory();
+
 private:
   // Static configuration. Port, keys, etc. ====================
   // Certificate that should be used (includes private key)
@@ -39,6 +56,8 @@ private:
  
   //// Runtime data ============================================
   SSL_CTX * _sslctx;
+  // Number of entries of the session cache, limited by the free heap when the server is started
+  unsigned long _sessionCacheSize;
   // Status of the server: Are we running, or not?
 
   // Setup functions
@@ -46,9 +65,31 @@ private:
   virtual void teardownSocket();
   uint8_t setupSSLCTX();
   uint8_t setupCert();
+  void setupSessionResumption();
+
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+  // Keys used to encrypt and authenticate session tickets
+  struct TicketKey {
+    unsigned char name[16];
+    unsigned char aesKey[16];
+    unsigned char hmacKey[32];
+    // Timestamp of the creation of the key
+    unsigned long created;
+  };
+  // Index 0 is used for new tickets, index 1 holds the previous key
+  TicketKey _ticketKeys[2];
+  // The callback may be called by several workers at once
+  std::mutex _ticketKeyMutex;
+
+  void rotateTicketKeys();
+  void createTicketKey(TicketKey &key);
+  static int ticketKeyCallback(SSL * ssl, unsigned char keyName[16], unsigned char * iv,
+    EVP_CIPHER_CTX * cipherCtx, HMAC_CTX * hmacCtx, int encrypt);
+#endif
 
   // Helper functions
-  virtual int createConnection(int idx);
+  virtual HTTPConnection * createConnection(TimerWheel * timerWheel);
+  virtual int initializeConnection(HTTPConnection * connection);
 };
 
 } /* namespace httpsserver */
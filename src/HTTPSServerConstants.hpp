@@ -42,31 +42,111 @@
   #define HTTPS_LOGD(...) do {} while (0)
 #endif
 
-// The following lines define limits of the protocol. Exceeding these limits will lead to a 500 error
+// The following lines define limits of the protocol. Exceeding these limits will lead to a 500 error,
+// or to 431 Request Header Fields Too Large for the header limits
 
 // Maximum of header lines that are parsed
 #define HTTPS_REQUEST_MAX_HEADERS               20
 
-// Maximum length of the request line (GET /... HTTP/1.1)
-#define HTTPS_REQUEST_MAX_REQUEST_LENGTH       128
+// Maximum length of the request head (the request line and the header lines, stored with a single
+// line break each). The buffer for the head starts with HTTPS_REQUEST_HEAD_BUFFER_SIZE bytes when the
+// first request arrives and grows up to this size, the headers of a request are parsed in place.
+#ifndef HTTPS_REQUEST_MAX_HEAD_LENGTH
+  #define HTTPS_REQUEST_MAX_HEAD_LENGTH        8192
+#endif
+
+// Initial size of the buffer for the request head, enough for the headers of most requests
+#ifndef HTTPS_REQUEST_HEAD_BUFFER_SIZE
+  #define HTTPS_REQUEST_HEAD_BUFFER_SIZE       512
+#endif
+
+// Maximum length of the request line (GET /... HTTP/1.1), limited by HTTPS_REQUEST_MAX_HEAD_LENGTH
+#define HTTPS_REQUEST_MAX_REQUEST_LENGTH       1024
 
 // Maximum length of a header line (including name and value)
 #define HTTPS_REQUEST_MAX_HEADER_LENGTH        384
 
+// Maximum number of clients that are accepted from the listen backlog during one server loop.
+// Browsers open several connections at once, which can then be served without waiting for further loops.
+#ifndef HTTPS_MAX_ACCEPTS_PER_LOOP
+  #define HTTPS_MAX_ACCEPTS_PER_LOOP           4
+#endif
+
 // Chunk size used for reading data from the ssl-enabled socket
 #define HTTPS_CONNECTION_DATA_CHUNK_SIZE       512
 
+// Size of the output buffer of each connection. Small writes (status line, headers, print() calls)
+// are collected there and sent together, so they don't end up in many small TLS records/TCP segments
+#ifndef HTTPS_CONNECTION_SEND_BUFFER_SIZE
+  #define HTTPS_CONNECTION_SEND_BUFFER_SIZE    1400
+#endif
+
 // Size (in bytes) of the Connection:keep-alive Cache (we need to be able to
 // store-and-forward the response to calculate the content-size)
 #define HTTPS_KEEPALIVE_CACHESIZE              1400
 
+// Size of the per-connection arena that holds the headers, parameters and the keep-alive cache of
+// the current request. It is allocated with the first request of a connection and freed when the
+// connection is closed. The default fits the keep-alive cache and a request with about ten headers,
+// if a request needs more, the rest is taken from the heap.
+#ifndef HTTPS_REQUEST_ARENA_SIZE
+  #define HTTPS_REQUEST_ARENA_SIZE             (HTTPS_KEEPALIVE_CACHESIZE + 768)
+#endif
+
 // Timeout for an HTTPS connection without any transmission
 #define HTTPS_CONNECTION_TIMEOUT               20000
 
+// Time (ms) a client has to send the complete request head once it has started sending it. It is
+// not extended by further data, so a client cannot hold the connection by sending the head slowly.
+#ifndef HTTPS_HEADER_TIMEOUT
+  #define HTTPS_HEADER_TIMEOUT                 10000
+#endif
+
+// Timeout for the TLS handshake of a new connection (ms)
+#define HTTPS_HANDSHAKE_TIMEOUT                5000
+
 // Timeout used to wait for shutdown of SSL connection (ms)
 // (time for the client to return notify close flag) - without it, truncation attacks might be possible
 #define HTTPS_SHUTDOWN_TIMEOUT                 5000
 
+// Time (ms) that HTTPServer::drain() gives requests in progress before all connections are closed
+#ifndef HTTPS_DRAIN_TIMEOUT
+  #define HTTPS_DRAIN_TIMEOUT                  10000
+#endif
+
+// Resolution (ms) of the timer wheel that runs the timeouts above. Timers may fire up to this much
+// later than requested.
+#ifndef HTTPS_TIMER_RESOLUTION
+  #define HTTPS_TIMER_RESOLUTION               10
+#endif
+
+// Maximum number of TLS sessions kept in the server-side session cache. Clients that reconnect within
+// the session timeout can resume their session and skip the expensive key exchange. The server may
+// use fewer entries, see HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP.
+#ifndef HTTPS_SSL_SESSION_CACHE_SIZE
+  #define HTTPS_SSL_SESSION_CACHE_SIZE         8
+#endif
+
+// Heap (bytes) that is accounted for each entry of the session cache. With OpenSSL 3.0 (host build),
+// a session without client certificate takes about 1100 bytes. Client certificates add their size.
+#ifndef HTTPS_SSL_SESSION_ENTRY_SIZE
+  #define HTTPS_SSL_SESSION_ENTRY_SIZE         1200
+#endif
+
+// Free heap (bytes) that a full session cache has to leave. When the server is started, the cache
+// gets only as many entries (up to HTTPS_SSL_SESSION_CACHE_SIZE) as fit into the free heap above this
+// limit. If not even one fits, the cache is disabled, and only session tickets are used.
+#ifndef HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP
+  #define HTTPS_SSL_SESSION_CACHE_MIN_FREE_HEAP 32768
+#endif
+
+// Lifetime of a session ticket key (ms). After that time, a new key is used to issue tickets. Tickets
+// of the previous key are still accepted (and renewed) until the key is twice this old, so a ticket is
+// valid for at most twice this time.
+#ifndef HTTPS_SSL_TICKET_KEY_LIFETIME
+  #define HTTPS_SSL_TICKET_KEY_LIFETIME        300000
+#endif
+
 // Length of a SHA1 hash
 #define HTTPS_SHA1_LENGTH                      20
 
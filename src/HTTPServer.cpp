@@ -3,18 +3,28 @@
 namespace httpsserver {
 
 
-HTTPServer::HTTPServer(const uint16_t port, const uint8_t maxConnections, const in_addr_t bindAddress):
+HTTPServer::HTTPServer(const uint16_t port, const uint8_t maxConnections, const in_addr_t bindAddress,
+    const uint8_t workerCount):
   _port(port),
   _maxConnections(maxConnections),
-  _bindAddress(bindAddress) {
-
-  // Create space for the connections
-  _connections = new HTTPConnection*[maxConnections];
-  for(uint8_t i = 0; i < maxConnections; i++) _connections[i] = NULL;
+  _bindAddress(bindAddress),
+  _workerCount(workerCount > 0 ? workerCount : 1) {
+
+  // Split the connections among the workers. The connections themselves are created in start()
+  _workers = new HTTPWorker*[_workerCount];
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    uint8_t workerConnections = maxConnections / _workerCount + (i < maxConnections % _workerCount ? 1 : 0);
+    _workers[i] = new HTTPWorker(this, workerConnections);
+  }
 
   // Configure runtime data
   _socket = -1;
   _running = false;
+  _draining = false;
+  _drainRequest = 0;
+  _drainDeadline = 0;
+  _stoppedWorkerCount = 0;
+  _acceptLock.clear();
 }
 
 HTTPServer::~HTTPServer() {
@@ -25,8 +35,10 @@ HTTPServer::~HTTPServer() {
     stop();
   }
 
-  // Delete connection pointers
-  delete[] _connections;
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    delete _workers[i];
+  }
+  delete[] _workers;
 }
 
 /**
@@ -34,10 +46,22 @@ HTTPServer::~HTTPServer() {
  */
 uint8_t HTTPServer::start() {
   if (!_running) {
+    _draining = false;
+    _stoppedWorkerCount = 0;
+    _acceptLock.clear();
+    for(uint8_t i = 0; i < _workerCount; i++) {
+      _workers[i]->setupConnections();
+    }
     if (setupSocket()) {
+      for(uint8_t i = 0; i < _workerCount; i++) {
+        _workers[i]->_running = true;
+      }
       _running = true;
       return 1;
     }
+    for(uint8_t i = 0; i < _workerCount; i++) {
+      _workers[i]->teardownConnections();
+    }
     return 0;
   } else {
     return 1;
@@ -49,36 +73,90 @@ bool HTTPServer::isRunning() {
 }
 
 /**
- * This method stops the server
+ * Returns true while the server is shutting down after a call to drain()
+ */
+bool HTTPServer::isDraining() {
+  return _draining;
+}
+
+/**
+ * Returns the number of connections that are currently open. During drain(), this can be used
+ * to follow the progress of the shutdown.
+ */
+uint8_t HTTPServer::getOpenConnectionCount() {
+  uint8_t count = 0;
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    count += _workers[i]->getOpenConnectionCount();
+  }
+  return count;
+}
+
+/**
+ * This method stops the server.
+ *
+ * All connections are closed right away, but the call blocks until the TLS connections have been
+ * shut down (at most HTTPS_SHUTDOWN_TIMEOUT). Use drain() to shut down without blocking.
+ *
+ * With several workers, the tasks that call loop(worker) must have been stopped before, as stop()
+ * runs the workers itself.
  */
 void HTTPServer::stop() {
 
   if (_running) {
-    // Set the flag that the server is stopped
-    _running = false;
+    drain(0);
+    while(_running) {
+      loop();
+      delay(1);
+    }
+  }
+}
 
-    // Clean up the connections
-    bool hasOpenConnections = true;
-    while(hasOpenConnections) {
-      hasOpenConnections = false;
-      for(int i = 0; i < _maxConnections; i++) {
-        if (_connections[i] != NULL) {
-          _connections[i]->closeConnection();
-
-          // Check if closing succeeded. If not, we need to call the close function multiple times
-          // and wait for the client
-          if (_connections[i]->isClosed()) {
-            delete _connections[i];
-          } else {
-            hasOpenConnections = true;
-          }
-        }
-      }
+/**
+ * Starts a graceful shutdown of the server and returns immediately.
+ *
+ * The server does not accept new clients anymore and closes connections that wait for a request.
+ * Requests that are processed at the moment can finish, but their connections are not kept alive.
+ * When the timeout (ms) has expired, the remaining connections are closed, too.
+ *
+ * loop() has to be called as before until isRunning() returns false. Calling drain() again
+ * changes the timeout. This function may be called from any task.
+ */
+void HTTPServer::drain(unsigned long timeout) {
+  if (!_running) return;
+
+  _drainDeadline = (uint32_t)millis() + timeout;
+  if (!_draining.exchange(true)) {
+    HTTPS_LOGI("Draining server. %d open connections", getOpenConnectionCount());
+
+    // Take the accept lock for good, so that no worker uses the server socket anymore. If a worker
+    // is accepting at the moment, we wait for it to finish.
+    while(!tryLockAccept()) {
       delay(1);
     }
 
-    teardownSocket();
+    // Stop listening, so that new clients are refused instead of waiting in the backlog
+    close(_socket);
+  }
+
+  // Let the workers know. They drain their own connections in their next loop
+  _drainRequest++;
+}
 
+/**
+ * Called by each worker when it has closed its last connection after drain(). The last worker
+ * completes the shutdown.
+ */
+void HTTPServer::workerStopped() {
+  if (++_stoppedWorkerCount == _workerCount) {
+    HTTPS_LOGI("Server stopped");
+    for(uint8_t i = 0; i < _workerCount; i++) {
+      _workers[i]->teardownConnections();
+    }
+    // The socket has already been closed by drain()
+    _socket = -1;
+    teardownSocket();
+    _draining = false;
+    _running = false;
   }
 }
 
@@ -88,79 +166,107 @@ void HTTPServer::stop() {
  * This could be used for example to add a Server: header or for CORS options
  */
 void HTTPServer::setDefaultHeader(std::string name, std::string value) {
-  _defaultHeaders.set(new HTTPHeader(name, value));
+  _defaultHeaders.set(name, value);
+  // The responses copy the serialized block, so it only has to be created once
+  _defaultHeaders.serialize();
 }
 
 /**
- * The loop method can either be called by periodical interrupt or in the main loop and handles processing
- * of data
+ * Returns the timer wheel of a worker, or NULL if there is no such worker.
+ *
+ * Timers that are scheduled on it are run by the worker's loop, so applications can use it for their
+ * own timeouts without checking millis() on their own. The wheel has no locking: It may only be
+ * used from the task that calls loop(worker) for this worker, or from the task that calls loop()
+ * if all workers are run by a single task.
  */
-void HTTPServer::loop() {
+TimerWheel * HTTPServer::getTimerWheel(uint8_t worker) {
+  return worker < _workerCount ? _workers[worker]->getTimerWheel() : NULL;
+}
 
-  // Only handle requests if the server is still running
-  if(!_running) return;
+/**
+ * Returns the number of responses that have been sent since the server has been started
+ */
+unsigned long HTTPServer::getResponseCount() {
+  unsigned long count = 0;
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    count += _workers[i]->getResponseCount();
+  }
+  return count;
+}
 
-  // Step 1: Process existing connections
-  // Process open connections and store the index of a free connection
-  // (we might use that later on)
-  int freeConnectionIdx = -1;
-  for (int i = 0; i < _maxConnections; i++) {
-    // Fetch a free index in the pointer array
-    if (_connections[i] == NULL) {
-      freeConnectionIdx = i;
+/**
+ * Returns the number of socket writes (TLS records for HTTPS) since the server has been started.
+ *
+ * Together with getResponseCount(), this shows how well small writes are combined.
+ */
+unsigned long HTTPServer::getSocketWriteCount() {
+  unsigned long count = 0;
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    count += _workers[i]->getSocketWriteCount();
+  }
+  return count;
+}
 
-    } else {
-      // if there is a connection (_connections[i]!=NULL), check if its open or closed:
-      if (_connections[i]->isClosed()) {
-        // if it's closed, clean up:
-        delete _connections[i];
-        _connections[i] = NULL;
-        freeConnectionIdx = i;
-      } else {
-        // if not, process it:
-        _connections[i]->loop();
-      }
-    }
+/**
+ * The loop method can either be called by periodical interrupt or in the main loop and handles processing
+ * of data. If the server has several workers, all of them are run one after another.
+ */
+void HTTPServer::loop() {
+  for(uint8_t i = 0; i < _workerCount; i++) {
+    _workers[i]->loop();
   }
- 
-  // Step 2: Check for new connections
-  // This makes only sense if there is space to store the connection
-  if (freeConnectionIdx > -1) {
-
-    // We create a file descriptor set to be able to use the select function
-    fd_set sockfds;
-    // Out socket is the only socket in this set
-    FD_ZERO(&sockfds);
-    FD_SET(_socket, &sockfds);
-
-    // We define a "immediate" timeout
-    timeval timeout;
-    timeout.tv_sec  = 0;
-    timeout.tv_usec = 0; // Return immediately, if possible
-
-    // Wait for input
-    // As by 2017-12-14, it seems that FD_SETSIZE is defined as 0x40, but socket IDs now
-    // start at 0x1000, so we need to use _socket+1 here
-    select(_socket + 1, &sockfds, NULL, NULL, &timeout);
-
-    // There is input
-    if (FD_ISSET(_socket, &sockfds)) {
-      int socketIdentifier = createConnection(freeConnectionIdx);
-
-      // If initializing did not work, discard the new socket immediately
-      if (socketIdentifier < 0) {
-        delete _connections[freeConnectionIdx];
-        _connections[freeConnectionIdx] = NULL;
-      }
-    }
+}
 
+/**
+ * Runs a single worker. With several workers, each one can be run by its own task (e.g. one task
+ * per CPU core), calling loop(worker) in the same way as loop() is used otherwise.
+ */
+void HTTPServer::loop(uint8_t worker) {
+  if (worker < _workerCount) {
+    _workers[worker]->loop();
   }
 }
 
-int HTTPServer::createConnection(int idx) {
-  HTTPConnection * newConnection = new HTTPConnection(this);
-  _connections[idx] = newConnection;
-  return newConnection->initialize(_socket, &_defaultHeaders);
+/**
+ * Returns the number of workers, see loop(worker)
+ */
+uint8_t HTTPServer::getWorkerCount() {
+  return _workerCount;
+}
+
+/**
+ * Checks if another client is waiting in the backlog of the server socket, so that accept() won't block
+ */
+bool HTTPServer::hasPendingConnection() {
+  fd_set sockfds;
+  FD_ZERO(&sockfds);
+  FD_SET(_socket, &sockfds);
+
+  timeval timeout;
+  timeout.tv_sec  = 0;
+  timeout.tv_usec = 0;
+
+  return select(_socket + 1, &sockfds, NULL, NULL, &timeout) > 0;
+}
+
+/**
+ * Tries to get the permission to accept clients on the server socket. Returns false if another
+ * worker is accepting at the moment or if the server is draining.
+ */
+bool HTTPServer::tryLockAccept() {
+  return !_acceptLock.test_and_set(std::memory_order_acquire);
+}
+
+void HTTPServer::unlockAccept() {
+  _acceptLock.clear(std::memory_order_release);
+}
+
+HTTPConnection * HTTPServer::createConnection(TimerWheel * timerWheel) {
+  return new HTTPConnection(this, timerWheel);
+}
+
+int HTTPServer::initializeConnection(HTTPConnection * connection) {
+  return connection->initialize(_socket, &_defaultHeaders);
 }
 
 /**
@@ -202,9 +308,11 @@ uint8_t HTTPServer::setupSocket() {
 }
 
 void HTTPServer::teardownSocket() {
-  // Close the actual server sockets
-  close(_socket);
-  _socket = -1;
+  // Close the actual server sockets (unless drain() has already done so)
+  if (_socket >= 0) {
+    close(_socket);
+    _socket = -1;
+  }
 }
 
 } /* namespace httpsserver */
@@ -3,6 +3,9 @@
 
 // Standard library
 #include <string>
+#undef min
+#undef max
+#include <atomic>
 
 // Arduino stuff
 #include <Arduino.h>
@@ -21,26 +24,45 @@
 #include "ResourceResolver.hpp"
 #include "ResolvedResource.hpp"
 #include "HTTPConnection.hpp"
+#include "TimerWheel.hpp"
+#include "HTTPWorker.hpp"
 
 namespace httpsserver {
 
 /**
  * \brief Main implementation for the plain HTTP server. Use HTTPSServer for TLS support
+ *
+ * With workerCount > 1, the connections are split among several workers (see HTTPWorker), so that
+ * each of them can be run by a task on its own core. maxConnections is the total for all workers.
  */
 class HTTPServer : public ResourceResolver {
 public:
-  HTTPServer(const uint16_t portHTTPS = 80, const uint8_t maxConnections = 8, const in_addr_t bindAddress = 0);
+  HTTPServer(const uint16_t portHTTPS = 80, const uint8_t maxConnections = 8, const in_addr_t bindAddress = 0,
+    const uint8_t workerCount = 1);
   virtual ~HTTPServer();
 
   uint8_t start();
   void stop();
+  void drain(unsigned long timeout = HTTPS_DRAIN_TIMEOUT);
   bool isRunning();
+  bool isDraining();
+  uint8_t getOpenConnectionCount();
 
   void loop();
+  void loop(uint8_t worker);
+  uint8_t getWorkerCount();
 
   void setDefaultHeader(std::string name, std::string value);
 
+  TimerWheel * getTimerWheel(uint8_t worker = 0);
+
+  // Output statistics
+  unsigned long getResponseCount();
+  unsigned long getSocketWriteCount();
+
 protected:
+  friend class HTTPWorker;
+
   // Static configuration. Port, keys, etc. ====================
   // Certificate that should be used (includes private key)
   const uint16_t _port;
@@ -49,13 +71,26 @@ protected:
   const uint8_t _maxConnections;
   // Address to bind to (0 = all interfaces)
   const in_addr_t _bindAddress;
+  // Number of workers that share the server socket
+  const uint8_t _workerCount;
 
   //// Runtime data ============================================
-  // The array of connections that are currently active
-  HTTPConnection ** _connections;
+  // The workers, each with its own pool of connections
+  HTTPWorker ** _workers;
   // Status of the server: Are we running, or not?
-  boolean _running;
-  // The server socket
+  std::atomic<bool> _running;
+  // True between drain() and the end of the shutdown
+  std::atomic<bool> _draining;
+  // Incremented by each call to drain(), so that the workers notice it
+  std::atomic<uint32_t> _drainRequest;
+  // Value of millis() at which the drain timeout expires
+  std::atomic<uint32_t> _drainDeadline;
+  // Number of workers that have closed all their connections after drain()
+  std::atomic<uint8_t> _stoppedWorkerCount;
+  // Held by the worker that is using the server socket. drain() keeps it, so that nobody accepts anymore
+  std::atomic_flag _acceptLock;
+  // The server socket. While the server is running, the workers only use it while holding _acceptLock,
+  // as drain() closes it from another task.
   int _socket;
 
   // The server socket address, that our service is bound to
@@ -67,8 +102,15 @@ protected:
   virtual uint8_t setupSocket();
   virtual void teardownSocket();
 
+  // Used by the workers
+  bool hasPendingConnection();
+  bool tryLockAccept();
+  void unlockAccept();
+  void workerStopped();
+
   // Helper functions
-  virtual int createConnection(int idx);
+  virtual HTTPConnection * createConnection(TimerWheel * timerWheel);
+  virtual int initializeConnection(HTTPConnection * connection);
 };
 
 }
@@ -0,0 +1,56 @@
+#include "HTTPSpan.hpp"
+
+namespace httpsserver {
+
+bool HTTPSpan::equals(const HTTPSpan &other) const {
+  return _length == other._length && memcmp(_data, other._data, _length) == 0;
+}
+
+/**
+ * Compares two spans ignoring the case of ASCII letters, as it is required for header names
+ */
+bool HTTPSpan::equalsIgnoreCase(const HTTPSpan &other) const {
+  if (_length != other._length) {
+    return false;
+  }
+  for(size_t i = 0; i < _length; i++) {
+    char a = _data[i];
+    char b = other._data[i];
+    if (a != b) {
+      if (a >= 'A' && a <= 'Z') a += 'a' - 'A';
+      if (b >= 'A' && b <= 'Z') b += 'a' - 'A';
+      if (a != b) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns true if other occurs somewhere in this span
+ */
+bool HTTPSpan::contains(const HTTPSpan &other) const {
+  if (other._length == 0) {
+    return true;
+  }
+  const char * end = _data + _length;
+  const char * pos = _data;
+  while(end - pos >= (ptrdiff_t)other._length) {
+    pos = (const char *)memchr(pos, other._data[0], end - pos - other._length + 1);
+    if (pos == NULL) {
+      return false;
+    }
+    if (memcmp(pos, other._data, other._length) == 0) {
+      return true;
+    }
+    pos++;
+  }
+  return false;
+}
+
+std::string HTTPSpan::str() const {
+  return std::string(_data, _length);
+}
+
+} /* namespace httpsserver */
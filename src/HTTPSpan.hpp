@@ -0,0 +1,40 @@
+#ifndef SRC_HTTPSPAN_HPP_
+#define SRC_HTTPSPAN_HPP_
+
+#include <Arduino.h>
+#include <string>
+
+namespace httpsserver {
+
+/**
+ * \brief Non-owning reference to a sequence of characters, e.g. a part of the request head
+ *
+ * Used by the request parser to refer to the method, headers etc. without copying them into
+ * separate strings. A span is only valid as long as the memory it points to, so it must not
+ * be stored beyond the request it belongs to. Use str() to get a copy.
+ */
+class HTTPSpan {
+public:
+  constexpr HTTPSpan(): _data(NULL), _length(0) {}
+  constexpr HTTPSpan(const char * data, size_t length): _data(data), _length(length) {}
+  HTTPSpan(const char * str): _data(str), _length(str == NULL ? 0 : strlen(str)) {}
+  HTTPSpan(const std::string &str): _data(str.data()), _length(str.length()) {}
+
+  const char * data() const { return _data; }
+  size_t length() const { return _length; }
+  bool empty() const { return _length == 0; }
+
+  bool equals(const HTTPSpan &other) const;
+  bool equalsIgnoreCase(const HTTPSpan &other) const;
+  bool contains(const HTTPSpan &other) const;
+
+  std::string str() const;
+
+private:
+  const char * _data;
+  size_t _length;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_HTTPSPAN_HPP_ */
@@ -0,0 +1,265 @@
+#include "HTTPWorker.hpp"
+#include "HTTPServer.hpp"
+
+namespace httpsserver {
+
+HTTPWorker::HTTPWorker(HTTPServer * server, const uint8_t maxConnections):
+  _server(server),
+  _maxConnections(maxConnections) {
+
+  // Create space for the connection pool. The connections themselves are created in start()
+  _connections = new HTTPConnection*[maxConnections];
+  for(uint8_t i = 0; i < maxConnections; i++) _connections[i] = NULL;
+  _freeConnections = new HTTPConnection*[maxConnections];
+  _freeConnectionCount = 0;
+  _activeConnections = new HTTPConnection*[maxConnections];
+  _activeConnectionCount = 0;
+
+  _running = false;
+  _draining = false;
+  _drainRequest = 0;
+  _drainTimer.setCallback([this]() { closeAllConnections(); });
+}
+
+HTTPWorker::~HTTPWorker() {
+  teardownConnections();
+
+  // Delete connection pointers
+  delete[] _connections;
+  delete[] _freeConnections;
+  delete[] _activeConnections;
+}
+
+/**
+ * Processes the connections of this worker and accepts new clients. Called by HTTPServer::loop().
+ */
+void HTTPWorker::loop() {
+
+  // Only handle requests if the server is still running
+  if(!_running) return;
+
+  // Run the timers that have expired since the last call, e.g. to close connections that timed out
+  _timerWheel.update(millis());
+
+  // Pick up calls to HTTPServer::drain()
+  uint32_t drainRequest = _server->_drainRequest;
+  if (drainRequest != _drainRequest) {
+    _drainRequest = drainRequest;
+    int32_t remaining = (int32_t)(_server->_drainDeadline - (uint32_t)millis());
+    drain(remaining > 0 ? remaining : 0);
+  }
+
+  // Step 1: Check which sockets have pending input
+  // We do this for the server socket and all open connections at once, so that the connections
+  // do not need to call select() on their own. On the way, we return closed connections to the
+  // pool. Iterating backwards keeps this safe, as releasing moves the last entry to the current index.
+  fd_set sockfds;
+  FD_ZERO(&sockfds);
+  int maxSocket = -1;
+  for (int i = _activeConnectionCount - 1; i >= 0; i--) {
+    if (_activeConnections[i]->isClosed()) {
+      releaseConnection(i);
+
+    } else {
+      // if not, add it to the set of sockets to check
+      int connectionSocket = _activeConnections[i]->getSocket();
+      if (connectionSocket >= 0) {
+        FD_SET(connectionSocket, &sockfds);
+        if (connectionSocket > maxSocket) maxSocket = connectionSocket;
+      }
+    }
+  }
+
+  // The shutdown is complete as soon as the last connection has been closed
+  if (_draining && _activeConnectionCount == 0) {
+    _drainTimer.cancel();
+    _draining = false;
+    _running = false;
+    _server->workerStopped();
+    return;
+  }
+
+  // Checking for new connections makes only sense if there is space to store the connection
+  // (and if the server still accepts connections). drain() may close the server socket from another
+  // task, so it is only used while holding the accept lock. If another worker holds it, that worker
+  // takes care of the waiting clients.
+  int serverSocket = -1;
+  bool checkServerSocket = !_draining && !_server->_draining && _freeConnectionCount > 0 && _server->tryLockAccept();
+  if (checkServerSocket) {
+    serverSocket = _server->_socket;
+    FD_SET(serverSocket, &sockfds);
+    if (serverSocket > maxSocket) maxSocket = serverSocket;
+  }
+
+  // We define a "immediate" timeout
+  timeval timeout;
+  timeout.tv_sec  = 0;
+  timeout.tv_usec = 0; // Return immediately, if possible
+
+  // As by 2017-12-14, it seems that FD_SETSIZE is defined as 0x40, but socket IDs now
+  // start at 0x1000, so we need to use maxSocket+1 here
+  int selectResult = maxSocket < 0 ? 0 : select(maxSocket + 1, &sockfds, NULL, NULL, &timeout);
+  if (selectResult < 0) {
+    // The sets are undefined now. The connections will check their sockets on their own.
+    FD_ZERO(&sockfds);
+  }
+  bool canAccept = checkServerSocket && FD_ISSET(serverSocket, &sockfds);
+  if (checkServerSocket) {
+    // acceptConnections() takes the lock again, so that it is not held while requests are handled
+    _server->unlockAccept();
+  }
+
+  // Step 2: Process existing connections
+  for (int i = 0; i < _activeConnectionCount; i++) {
+    HTTPConnection * connection = _activeConnections[i];
+    if (!connection->isClosed()) {
+      if (selectResult >= 0) {
+        int connectionSocket = connection->getSocket();
+        connection->setReadiness(connectionSocket >= 0 && FD_ISSET(connectionSocket, &sockfds));
+      }
+      connection->loop();
+    }
+  }
+
+  // Step 3: Check for new connections
+  if (canAccept) {
+    acceptConnections();
+  }
+}
+
+/**
+ * Accepts the clients that are waiting on the server socket.
+ *
+ * If more clients are waiting in the backlog, we accept them right away (as long as there are free
+ * connections and HTTPS_MAX_ACCEPTS_PER_LOOP is not exceeded) instead of taking one per loop.
+ * Only one worker can accept at a time, the others skip accepting if they don't get the lock.
+ */
+void HTTPWorker::acceptConnections() {
+  // (A request handler may have called drain() in the meantime, which keeps the lock, so the
+  // server socket is still open if we get it)
+  if (!_server->tryLockAccept()) {
+    return;
+  }
+
+  // With several workers, another one may have taken the client since our select()
+  if (_server->_workerCount == 1 || _server->hasPendingConnection()) {
+    int acceptBudget = HTTPS_MAX_ACCEPTS_PER_LOOP;
+    do {
+      HTTPConnection * connection = _freeConnections[--_freeConnectionCount];
+      int socketIdentifier = _server->initializeConnection(connection);
+
+      if (socketIdentifier >= 0) {
+        _activeConnections[_activeConnectionCount++] = connection;
+      } else {
+        // If initializing did not work, put the connection back to the pool immediately
+        connection->reset();
+        _freeConnections[_freeConnectionCount++] = connection;
+      }
+      acceptBudget--;
+    } while(acceptBudget > 0 && _freeConnectionCount > 0 && _server->hasPendingConnection());
+  }
+
+  _server->unlockAccept();
+}
+
+/**
+ * Lets the connections of this worker finish their current requests (see HTTPServer::drain())
+ */
+void HTTPWorker::drain(unsigned long timeout) {
+  if (!_draining) {
+    _draining = true;
+    for(int i = _activeConnectionCount - 1; i >= 0; i--) {
+      _activeConnections[i]->drain();
+    }
+  }
+  _timerWheel.schedule(&_drainTimer, timeout);
+}
+
+/**
+ * Closes all open connections, e.g. when the drain timeout has expired. Connections that wait
+ * for the TLS shutdown are closed when their shutdown timeout expires.
+ */
+void HTTPWorker::closeAllConnections() {
+  for(int i = _activeConnectionCount - 1; i >= 0; i--) {
+    _activeConnections[i]->closeConnection();
+  }
+}
+
+/**
+ * Returns the timer wheel that runs the timeouts of this worker's connections
+ */
+TimerWheel * HTTPWorker::getTimerWheel() {
+  return &_timerWheel;
+}
+
+/**
+ * Returns the number of connections of this worker that are currently open
+ */
+uint8_t HTTPWorker::getOpenConnectionCount() {
+  return _activeConnectionCount;
+}
+
+/**
+ * Returns the number of responses that have been sent by this worker since the server has been started
+ */
+unsigned long HTTPWorker::getResponseCount() {
+  unsigned long count = 0;
+  for(uint8_t i = 0; i < _maxConnections; i++) {
+    if (_connections[i] != NULL) {
+      count += _connections[i]->getResponseCount();
+    }
+  }
+  return count;
+}
+
+/**
+ * Returns the number of socket writes (TLS records for HTTPS) of this worker since the server has been started
+ */
+unsigned long HTTPWorker::getSocketWriteCount() {
+  unsigned long count = 0;
+  for(uint8_t i = 0; i < _maxConnections; i++) {
+    if (_connections[i] != NULL) {
+      count += _connections[i]->getSocketWriteCount();
+    }
+  }
+  return count;
+}
+
+/**
+ * Creates the connection pool. All connection objects are allocated here, so that accepting
+ * a client does not need the heap.
+ */
+void HTTPWorker::setupConnections() {
+  for(uint8_t i = 0; i < _maxConnections; i++) {
+    _connections[i] = _server->createConnection(&_timerWheel);
+    _freeConnections[i] = _connections[i];
+  }
+  _freeConnectionCount = _maxConnections;
+  _activeConnectionCount = 0;
+  _draining = false;
+  _drainRequest = _server->_drainRequest;
+}
+
+/**
+ * Deletes the connection pool. All connections must have been closed before.
+ */
+void HTTPWorker::teardownConnections() {
+  for(uint8_t i = 0; i < _maxConnections; i++) {
+    delete _connections[i];
+    _connections[i] = NULL;
+  }
+  _freeConnectionCount = 0;
+  _activeConnectionCount = 0;
+}
+
+/**
+ * Returns a closed connection to the pool. The last active connection takes its place in the active list.
+ */
+void HTTPWorker::releaseConnection(uint8_t activeIdx) {
+  HTTPConnection * connection = _activeConnections[activeIdx];
+  connection->reset();
+  _freeConnections[_freeConnectionCount++] = connection;
+  _activeConnections[activeIdx] = _activeConnections[--_activeConnectionCount];
+}
+
+} /* namespace httpsserver */
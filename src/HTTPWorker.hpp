@@ -0,0 +1,88 @@
+#ifndef SRC_HTTPWORKER_HPP_
+#define SRC_HTTPWORKER_HPP_
+
+#include <Arduino.h>
+
+#undef min
+#undef max
+#include <atomic>
+
+// Required for sockets
+#include "lwip/netdb.h"
+#undef read
+#include "lwip/sockets.h"
+
+#include "HTTPSServerConstants.hpp"
+#include "HTTPConnection.hpp"
+#include "Timer.hpp"
+#include "TimerWheel.hpp"
+
+namespace httpsserver {
+
+class HTTPServer;
+
+/**
+ * \brief A server loop with its own table of connections
+ *
+ * Each HTTPServer has at least one worker. If it has several, each worker can be run by its own task
+ * (e.g. one per CPU core) by calling HTTPServer::loop(worker). The workers share the server socket
+ * and take turns accepting new clients, but a connection is only handled by the worker that has
+ * accepted it. The nodes and middleware of the server are only read by the workers.
+ */
+class HTTPWorker {
+public:
+  HTTPWorker(HTTPServer * server, const uint8_t maxConnections);
+  virtual ~HTTPWorker();
+
+  void loop();
+
+  TimerWheel * getTimerWheel();
+
+  // Output statistics
+  uint8_t getOpenConnectionCount();
+  unsigned long getResponseCount();
+  unsigned long getSocketWriteCount();
+
+private:
+  friend class HTTPServer;
+
+  // Connection pool
+  void setupConnections();
+  void teardownConnections();
+  void releaseConnection(uint8_t activeIdx);
+  void closeAllConnections();
+  void acceptConnections();
+
+  void drain(unsigned long timeout);
+
+  // The server that this worker belongs to
+  HTTPServer * _server;
+
+  // Max parallel connections of this worker
+  const uint8_t _maxConnections;
+
+  // Pool of connection objects. They are created in start() and recycled until the server is stopped
+  HTTPConnection ** _connections;
+  // Connections from the pool that can take the next client (used as stack)
+  HTTPConnection ** _freeConnections;
+  uint8_t _freeConnectionCount;
+  // Connections from the pool that are currently in use, in no particular order
+  HTTPConnection ** _activeConnections;
+  // Only changed by the worker itself, but read by getOpenConnectionCount() from any task
+  std::atomic<uint8_t> _activeConnectionCount;
+
+  // True from the start of the server until this worker has closed its last connection after drain()
+  std::atomic<bool> _running;
+  // True if this worker has picked up a drain() request of the server (only used by the worker itself)
+  bool _draining;
+  // Value of the server's drain request counter that has been handled last
+  uint32_t _drainRequest;
+  // Closes the remaining connections when the drain timeout has expired
+  Timer _drainTimer;
+  // Runs the timeouts of the connections of this worker
+  TimerWheel _timerWheel;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_HTTPWORKER_HPP_ */
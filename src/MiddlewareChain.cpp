@@ -0,0 +1,44 @@
+#include "MiddlewareChain.hpp"
+
+namespace httpsserver {
+
+MiddlewareChain::MiddlewareChain() {
+
+}
+
+MiddlewareChain::~MiddlewareChain() {
+
+}
+
+/**
+ * Replaces the chain by the given middleware functions, which are called in that order
+ */
+void MiddlewareChain::compile(const std::vector<HTTPSMiddlewareFunction*> &middleware) {
+  _functions = middleware;
+}
+
+/**
+ * Passes the request through the middleware functions. If all of them call next(), the handler
+ * is called at the end.
+ */
+void MiddlewareChain::invoke(HTTPRequest * req, HTTPResponse * res, HTTPSCallbackFunction * handler) const {
+  Call call;
+  call.chain = this;
+  call.req = req;
+  call.res = res;
+  call.handler = handler;
+  call.next(0);
+}
+
+void MiddlewareChain::Call::next(size_t idx) {
+  if (idx < chain->_functions.size()) {
+    Next next;
+    next.call = this;
+    next.idx = idx + 1;
+    chain->_functions[idx](req, res, std::function<void()>(next));
+  } else {
+    handler(req, res);
+  }
+}
+
+} /* namespace httpsserver */
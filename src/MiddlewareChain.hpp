@@ -0,0 +1,61 @@
+#ifndef SRC_MIDDLEWARECHAIN_HPP_
+#define SRC_MIDDLEWARECHAIN_HPP_
+
+#include <string>
+// Arduino declares it's own min max, incompatible with the stl...
+#undef min
+#undef max
+#include <vector>
+#include <functional>
+
+#include "HTTPRequest.hpp"
+#include "HTTPResponse.hpp"
+#include "HTTPSCallbackFunction.hpp"
+#include "HTTPMiddlewareFunction.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Precompiled chain of middleware functions
+ *
+ * The chain is a flat list of the middleware functions. It is built by compile() whenever the
+ * middleware of the server changes, not for each request. When a request is handled, invoke()
+ * calls the functions one after another. The next() function that is passed to a middleware
+ * function only refers to the position in the chain, so it fits into std::function without a heap
+ * allocation.
+ *
+ * invoke() only reads the chain, so several workers can use it at the same time.
+ */
+class MiddlewareChain {
+public:
+  MiddlewareChain();
+  virtual ~MiddlewareChain();
+
+  void compile(const std::vector<HTTPSMiddlewareFunction*> &middleware);
+  void invoke(HTTPRequest * req, HTTPResponse * res, HTTPSCallbackFunction * handler) const;
+
+private:
+  /** State of a single pass through the chain */
+  struct Call {
+    const MiddlewareChain * chain;
+    HTTPRequest * req;
+    HTTPResponse * res;
+    HTTPSCallbackFunction * handler;
+    void next(size_t idx);
+  };
+
+  /** The next() function that is passed to the middleware at position idx - 1 */
+  struct Next {
+    Call * call;
+    size_t idx;
+    void operator()() const {
+      call->next(idx);
+    }
+  };
+
+  std::vector<HTTPSMiddlewareFunction*> _functions;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_MIDDLEWARECHAIN_HPP_ */
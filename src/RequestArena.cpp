@@ -0,0 +1,94 @@
+#include "RequestArena.hpp"
+
+namespace httpsserver {
+
+// Alignment of all allocations, enough for any type stored in the arena
+#define ARENA_ALIGNMENT (sizeof(void*) > sizeof(double) ? sizeof(void*) : sizeof(double))
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+RequestArena::RequestArena(size_t size):
+  _size(ARENA_ALIGN(size)) {
+  _buffer = NULL;
+  _used = 0;
+  _cleanups = NULL;
+  _overflow = NULL;
+  _overflowCount = 0;
+}
+
+RequestArena::~RequestArena() {
+  reset();
+  delete[] _buffer;
+}
+
+/**
+ * Returns a block of at least size bytes that stays valid until the next reset()
+ */
+void * RequestArena::allocate(size_t size) {
+  size = ARENA_ALIGN(size);
+  if (_buffer == NULL) {
+    _buffer = new byte[_size];
+  }
+  if (size <= _size - _used) {
+    void * block = _buffer + _used;
+    _used += size;
+    return block;
+  }
+
+  // The buffer is full, take the block from the heap. The list header is placed in front of it.
+  HTTPS_LOGD("Request arena exhausted, allocating %u bytes on the heap", (unsigned)size);
+  _overflowCount++;
+  Overflow * overflow = (Overflow*)::operator new(ARENA_ALIGN(sizeof(Overflow)) + size);
+  overflow->next = _overflow;
+  _overflow = overflow;
+  return ((byte*)overflow) + ARENA_ALIGN(sizeof(Overflow));
+}
+
+/**
+ * Destroys all objects that have been created in the arena and makes the whole buffer available again
+ */
+void RequestArena::reset() {
+  // Objects are destroyed in reverse order of creation
+  while(_cleanups != NULL) {
+    Cleanup * cleanup = _cleanups;
+    _cleanups = cleanup->next;
+    cleanup->destroy(cleanup->object);
+  }
+  while(_overflow != NULL) {
+    Overflow * overflow = _overflow;
+    _overflow = overflow->next;
+    ::operator delete(overflow);
+  }
+  _used = 0;
+}
+
+/**
+ * Resets the arena and frees its buffer, which is allocated again when it is needed
+ */
+void RequestArena::release() {
+  reset();
+  delete[] _buffer;
+  _buffer = NULL;
+}
+
+/**
+ * Returns the size of the buffer
+ */
+size_t RequestArena::getSize() {
+  return _size;
+}
+
+/**
+ * Returns the number of bytes of the buffer that are currently in use
+ */
+size_t RequestArena::getUsed() {
+  return _used;
+}
+
+/**
+ * Returns the number of allocations that did not fit into the buffer since the arena has been created
+ */
+unsigned long RequestArena::getOverflowCount() {
+  return _overflowCount;
+}
+
+} /* namespace httpsserver */
@@ -0,0 +1,136 @@
+#ifndef SRC_REQUESTARENA_HPP_
+#define SRC_REQUESTARENA_HPP_
+
+#include <Arduino.h>
+
+#include <string>
+// Arduino declares it's own min max, incompatible with the stl...
+#undef min
+#undef max
+#include <vector>
+#include <utility>
+#include <new>
+#include <cstddef>
+
+#include "HTTPSServerConstants.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Bump allocator for the data of a single request
+ *
+ * Each connection owns an arena with a fixed buffer that is allocated with the first request and
+ * kept until the connection is returned to the pool (see release()). Headers, parameters, the
+ * response cache etc. are taken from it while the request is processed, and everything is released
+ * at once by reset() when the request is complete. This keeps malloc()/free() out of the request
+ * path and avoids heap fragmentation on long-running devices.
+ *
+ * If the buffer is exhausted, further memory is taken from the heap and freed on reset(), so an
+ * unusually large request still works. Objects created with create() are destroyed on reset().
+ */
+class RequestArena {
+public:
+  RequestArena(size_t size = HTTPS_REQUEST_ARENA_SIZE);
+  virtual ~RequestArena();
+
+  void * allocate(size_t size);
+  void reset();
+  void release();
+
+  /** Constructs an object in the arena. Its destructor is called by reset(). */
+  template<typename T, typename... Args>
+  T * create(Args&&... args) {
+    Cleanup * cleanup = (Cleanup*)allocate(sizeof(Cleanup));
+    T * object = new(allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    cleanup->object = object;
+    cleanup->destroy = &destroyObject<T>;
+    cleanup->next = _cleanups;
+    _cleanups = cleanup;
+    return object;
+  }
+
+  size_t getSize();
+  size_t getUsed();
+  unsigned long getOverflowCount();
+
+private:
+  /** Destructor call that is run on reset() */
+  struct Cleanup {
+    void * object;
+    void (*destroy)(void *);
+    Cleanup * next;
+  };
+
+  /** Heap block used when the buffer is exhausted */
+  struct Overflow {
+    Overflow * next;
+  };
+
+  template<typename T>
+  static void destroyObject(void * object) {
+    ((T*)object)->~T();
+  }
+
+  byte * _buffer;
+  const size_t _size;
+  size_t _used;
+  Cleanup * _cleanups;
+  Overflow * _overflow;
+  // Number of allocations that did not fit into the buffer
+  unsigned long _overflowCount;
+};
+
+/**
+ * \brief STL allocator that takes memory from a RequestArena
+ *
+ * Memory is only returned when the arena is reset, so containers using it must not outlive the
+ * request. Without an arena, the allocator uses the heap like std::allocator.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  ArenaAllocator(): _arena(NULL) {}
+  ArenaAllocator(RequestArena * arena): _arena(arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other): _arena(other._arena) {}
+
+  T * allocate(size_t n) {
+    if (_arena != NULL) {
+      return (T*)_arena->allocate(n * sizeof(T));
+    }
+    return (T*)::operator new(n * sizeof(T));
+  }
+
+  void deallocate(T * p, size_t) {
+    if (_arena == NULL) {
+      ::operator delete(p);
+    }
+  }
+
+  // Required for the C++11 library of the ESP32 toolchain, which does not fill in the defaults
+  template<typename U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+
+  RequestArena * _arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a._arena == b._arena;
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a._arena != b._arena;
+}
+
+/** String that keeps its characters in a RequestArena */
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+} /* namespace httpsserver */
+
+#endif /* SRC_REQUESTARENA_HPP_ */
@@ -2,20 +2,24 @@
 
 namespace httpsserver {
 
-ResolvedResource::ResolvedResource() {
+ResolvedResource::ResolvedResource(RequestArena * arena):
+  _arena(arena) {
   _matchingNode = NULL;
+  _staticRoute = NULL;
   _params = NULL;
+  _allowedMethods = 0;
 }
 
 ResolvedResource::~ResolvedResource() {
-  // Delete only params, nodes are reused/server-internal
-  if (_params != NULL) {
+  // Delete only params, nodes are reused/server-internal. Params from the arena are
+  // destroyed when the arena is reset.
+  if (_params != NULL && _arena == NULL) {
     delete _params;
   }
 }
 
 bool ResolvedResource::didMatch() {
-  return _matchingNode != NULL;
+  return _matchingNode != NULL || _staticRoute != NULL;
 }
 
 HTTPNode * ResolvedResource::getMatchingNode() {
@@ -26,15 +30,49 @@ void ResolvedResource::setMatchingNode(HTTPNode * node) {
   _matchingNode = node;
 }
 
+/**
+ * Returns the route if the request matched a StaticRoute. getMatchingNode() returns NULL then.
+ */
+const StaticRoute * ResolvedResource::getStaticRoute() {
+  return _staticRoute;
+}
+
+void ResolvedResource::setStaticRoute(const StaticRoute * route) {
+  _staticRoute = route;
+}
+
 ResourceParameters * ResolvedResource::getParams() {
   return _params;
 }
 
 void ResolvedResource::setParams(ResourceParameters * params) {
-  if (_params != NULL && _params!=params) {
+  if (_params != NULL && _params!=params && _arena == NULL) {
     delete _params;
   }
   _params = params;
 }
 
+/**
+ * Creates an empty parameter object for this resource. It is owned by the ResolvedResource once it
+ * has been passed to setParams().
+ */
+ResourceParameters * ResolvedResource::createParams() {
+  if (_arena != NULL) {
+    return _arena->create<ResourceParameters>(_arena);
+  }
+  return new ResourceParameters();
+}
+
+/**
+ * Returns the methods that would be accepted for the requested path if no node matched because of
+ * the request's method, or 0. The request can then be answered with 405 Method Not Allowed.
+ */
+HTTPMethodMask ResolvedResource::getAllowedMethods() {
+  return _allowedMethods;
+}
+
+void ResolvedResource::setAllowedMethods(HTTPMethodMask methods) {
+  _allowedMethods = methods;
+}
+
 } /* namespace httpsserver */
@@ -3,6 +3,8 @@
 
 #include "ResourceNode.hpp"
 #include "ResourceParameters.hpp"
+#include "StaticRoute.hpp"
+#include "RequestArena.hpp"
 
 namespace httpsserver {
 
@@ -11,18 +13,29 @@ namespace httpsserver {
  */
 class ResolvedResource {
 public:
-  ResolvedResource();
+  ResolvedResource(RequestArena * arena = NULL);
   ~ResolvedResource();
 
   void setMatchingNode(HTTPNode * node);
   HTTPNode * getMatchingNode();
+  void setStaticRoute(const StaticRoute * route);
+  const StaticRoute * getStaticRoute();
   bool didMatch();
   ResourceParameters * getParams();
   void setParams(ResourceParameters * params);
+  ResourceParameters * createParams();
+  HTTPMethodMask getAllowedMethods();
+  void setAllowedMethods(HTTPMethodMask methods);
 
 private:
+  // Arena that holds the params, NULL if they are allocated on the heap
+  RequestArena * _arena;
   HTTPNode * _matchingNode;
+  // Set instead of _matchingNode if the request matched a StaticRoute
+  const StaticRoute * _staticRoute;
   ResourceParameters * _params;
+  // Methods of the nodes that match the path if none of them accepts the request's method
+  HTTPMethodMask _allowedMethods;
 };
 
 } /* namespace httpsserver */
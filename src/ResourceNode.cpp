@@ -3,12 +3,22 @@
 namespace httpsserver {
 
 ResourceNode::ResourceNode(const std::string &path, const std::string &method, const HTTPSCallbackFunction * callback, const std::string &tag):
-  HTTPNode(path, HANDLER_CALLBACK, tag),
+  HTTPNode(path, HANDLER_CALLBACK, tag, parseMethod(method)),
   _method(method),
   _callback(callback) {
 
 }
 
+/**
+ * Creates a node that serves several methods, e.g. METHOD_GET | METHOD_HEAD
+ */
+ResourceNode::ResourceNode(const std::string &path, const HTTPMethodMask methods, const HTTPSCallbackFunction * callback, const std::string &tag):
+  HTTPNode(path, HANDLER_CALLBACK, tag, methods),
+  _method(getMethodNames(methods)),
+  _callback(callback) {
+
+}
+
 ResourceNode::~ResourceNode() {
   
 }
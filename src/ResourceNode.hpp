@@ -16,8 +16,10 @@ namespace httpsserver {
 class ResourceNode : public HTTPNode {
 public:
   ResourceNode(const std::string &path, const std::string &method, const HTTPSCallbackFunction * callback, const std::string &tag = "");
+  ResourceNode(const std::string &path, const HTTPMethodMask methods, const HTTPSCallbackFunction * callback, const std::string &tag = "");
   virtual ~ResourceNode();
 
+  /** The method as it has been passed to the constructor, or the list of methods (e.g. "GET, HEAD") */
   const std::string _method;
   const HTTPSCallbackFunction * _callback;
   std::string getMethod() { return _method; }
@@ -2,43 +2,113 @@
 
 namespace httpsserver {
 
-ResourceParameters::ResourceParameters() {
+ResourceParameters::ResourceParameters(RequestArena * arena):
+  _arena(arena),
+  _urlParams(ArenaAllocator<HTTPSpan>(arena)),
+  _queryParsed(true),
+  _reqParams(ArenaAllocator<RequestParam>(arena)) {
 
 }
 
 ResourceParameters::~ResourceParameters() {
-
+  for(size_t i = 0; i < _heapBlocks.size(); i++) {
+    delete[] _heapBlocks[i];
+  }
 }
 
 bool ResourceParameters::isRequestParameterSet(std::string const &name) {
-  for(auto reqParam = _reqParams.begin(); reqParam != _reqParams.end(); ++reqParam) {
-    if ((*reqParam).first.compare(name)==0) {
-      return true;
-    }
-  }
-  return false;
+  return findRequestParameter(name) != NULL;
 }
 
 std::string ResourceParameters::getRequestParameter(std::string const &name) {
-  for(auto reqParam = _reqParams.begin(); reqParam != _reqParams.end(); ++reqParam) {
-    if ((*reqParam).first.compare(name)==0) {
-      return (*reqParam).second;
-    }
-  }
-  return "";
+  HTTPSpan value;
+  getRequestParameterSpan(name, value);
+  return value.str();
 }
 
-uint16_t ResourceParameters::getRequestParameterInt(std::string const &name) {
+/**
+ * Returns a request parameter as int, or 0 if it is not set. Use getRequestParameterInt32() to
+ * find out whether the value is a valid number.
+ */
+int32_t ResourceParameters::getRequestParameterInt(std::string const &name) {
   return parseInt(getRequestParameter(name));
 }
 
-void ResourceParameters::setRequestParameter(std::string const &name, std::string const &value) {
-  std::pair<std::string, std::string> param;
-  param.first = name;
-  param.second = value;
+/**
+ * Returns the decoded value of a request parameter without copying it. Returns false if the
+ * parameter is not set.
+ *
+ * The value is valid as long as the parameters.
+ */
+bool ResourceParameters::getRequestParameterSpan(HTTPSpan const &name, HTTPSpan &value) {
+  RequestParam * param = findRequestParameter(name);
+  if (param == NULL) {
+    return false;
+  }
+  if (!param->valueDecoded) {
+    param->value = decodeSpan(param->value);
+    param->valueDecoded = true;
+  }
+  value = param->value;
+  return true;
+}
+
+/**
+ * Returns a request parameter as 32 bit integer. Returns false and leaves value unchanged if the
+ * parameter is not set, is not a decimal number, or is out of range.
+ */
+bool ResourceParameters::getRequestParameterInt32(HTTPSpan const &name, int32_t &value) {
+  int64_t v;
+  if (!getRequestParameterInt64(name, v) || v < INT32_MIN || v > INT32_MAX) {
+    return false;
+  }
+  value = (int32_t)v;
+  return true;
+}
+
+bool ResourceParameters::getRequestParameterInt64(HTTPSpan const &name, int64_t &value) {
+  HTTPSpan str;
+  return getRequestParameterSpan(name, str) && parseInt64(str, value);
+}
+
+bool ResourceParameters::getRequestParameterFloat(HTTPSpan const &name, float &value) {
+  HTTPSpan str;
+  return getRequestParameterSpan(name, str) && parseFloat(str, value);
+}
+
+/**
+ * Returns a request parameter as bool. See parseBool() for the accepted values.
+ */
+bool ResourceParameters::getRequestParameterBool(HTTPSpan const &name, bool &value) {
+  HTTPSpan str;
+  return getRequestParameterSpan(name, str) && parseBool(str, value);
+}
+
+/**
+ * Adds a request parameter. Name and value are copied and must not be encoded.
+ */
+void ResourceParameters::setRequestParameter(HTTPSpan const &name, HTTPSpan const &value) {
+  parseQueryString();
+  RequestParam param;
+  char * data = allocate(name.length() + value.length());
+  memcpy(data, name.data(), name.length());
+  memcpy(data + name.length(), value.data(), value.length());
+  param.name = HTTPSpan(data, name.length());
+  param.value = HTTPSpan(data + name.length(), value.length());
+  param.valueDecoded = true;
   _reqParams.push_back(param);
 }
 
+/**
+ * Sets the query string (the part of the request string after the '?'). It is not copied and only
+ * parsed when a request parameter is accessed for the first time.
+ */
+void ResourceParameters::setQueryString(HTTPSpan const &query) {
+  _reqParams.clear();
+  _queryString = query;
+  _queryParsed = query.empty();
+}
+
 /**
  * Returns an URL parameter as string.
  *
@@ -47,7 +117,7 @@ void ResourceParameters::setRequestParameter(std::string const &name, std::strin
  * The parameter idx defines the index of the parameter, starting with 0.
  */
 std::string ResourceParameters::getUrlParameter(uint8_t idx) {
-  return _urlParams.at(idx);
+  return _urlParams.at(idx).str();
 }
 
 /**
@@ -57,19 +127,234 @@ std::string ResourceParameters::getUrlParameter(uint8_t idx) {
  *
  * The parameter idx defines the index of the parameter, starting with 0.
  */
-uint16_t ResourceParameters::getUrlParameterInt(uint8_t idx) {
+int32_t ResourceParameters::getUrlParameterInt(uint8_t idx) {
   return parseInt(getUrlParameter(idx));
 }
 
+/**
+ * Returns an URL parameter without copying it, or an empty span if there is no such parameter.
+ * Unlike request parameters, URL parameters are not decoded.
+ */
+HTTPSpan ResourceParameters::getUrlParameterSpan(uint8_t idx) {
+  return idx < _urlParams.size() ? _urlParams[idx] : HTTPSpan();
+}
+
+bool ResourceParameters::getUrlParameterInt32(uint8_t idx, int32_t &value) {
+  int64_t v;
+  if (!getUrlParameterInt64(idx, v) || v < INT32_MIN || v > INT32_MAX) {
+    return false;
+  }
+  value = (int32_t)v;
+  return true;
+}
+
+bool ResourceParameters::getUrlParameterInt64(uint8_t idx, int64_t &value) {
+  return idx < _urlParams.size() && parseInt64(_urlParams[idx], value);
+}
+
+bool ResourceParameters::getUrlParameterFloat(uint8_t idx, float &value) {
+  return idx < _urlParams.size() && parseFloat(_urlParams[idx], value);
+}
+
+bool ResourceParameters::getUrlParameterBool(uint8_t idx, bool &value) {
+  return idx < _urlParams.size() && parseBool(_urlParams[idx], value);
+}
+
 void ResourceParameters::resetUrlParameters() {
   _urlParams.clear();
 }
 
-void ResourceParameters::setUrlParameter(uint8_t idx, std::string const &val) {
-  if(idx>=_urlParams.capacity()) {
+/**
+ * Sets an URL parameter. The value is not copied, so it must remain valid as long as the
+ * parameters.
+ */
+void ResourceParameters::setUrlParameter(uint8_t idx, HTTPSpan const &val) {
+  if(idx>=_urlParams.size()) {
     _urlParams.resize(idx + 1);
   }
-  _urlParams.at(idx) = val;
+  _urlParams[idx] = val;
+}
+
+/**
+ * Parses a decimal integer with an optional sign. Returns false and leaves value unchanged if
+ * the string contains anything else or if the number is out of range.
+ */
+bool ResourceParameters::parseInt64(HTTPSpan const &str, int64_t &value) {
+  const char * data = str.data();
+  size_t length = str.length();
+  size_t i = 0;
+  bool negative = false;
+  if (length > 0 && (data[0] == '-' || data[0] == '+')) {
+    negative = data[0] == '-';
+    i = 1;
+  }
+  if (i == length) {
+    return false;
+  }
+  // The magnitude of INT64_MIN is one more than INT64_MAX
+  uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  uint64_t v = 0;
+  for(; i < length; i++) {
+    char c = data[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    uint8_t digit = c - '0';
+    if (v > (limit - digit) / 10) {
+      return false;
+    }
+    v = v * 10 + digit;
+  }
+  value = negative ? (int64_t)(0 - v) : (int64_t)v;
+  return true;
+}
+
+/**
+ * Parses a decimal floating point number, e.g. "-1.5" or "2e3". Returns false and leaves value
+ * unchanged if the string contains anything else.
+ */
+bool ResourceParameters::parseFloat(HTTPSpan const &str, float &value) {
+  // strtof() needs a terminated string. Longer strings are no reasonable float values.
+  char buffer[32];
+  if (str.empty() || str.length() >= sizeof(buffer)) {
+    return false;
+  }
+  memcpy(buffer, str.data(), str.length());
+  buffer[str.length()] = 0;
+  // Don't accept leading whitespace, which strtof() would skip
+  if (isspace((unsigned char)buffer[0])) {
+    return false;
+  }
+  char * end;
+  float v = strtof(buffer, &end);
+  if (end != buffer + str.length()) {
+    return false;
+  }
+  value = v;
+  return true;
+}
+
+/**
+ * Parses "true", "1", "yes" and "on" as true and "false", "0", "no" and "off" as false, ignoring
+ * the case. Returns false and leaves value unchanged for any other string.
+ */
+bool ResourceParameters::parseBool(HTTPSpan const &str, bool &value) {
+  if (str.equalsIgnoreCase("true") || str.equals("1") || str.equalsIgnoreCase("yes") || str.equalsIgnoreCase("on")) {
+    value = true;
+    return true;
+  }
+  if (str.equalsIgnoreCase("false") || str.equals("0") || str.equalsIgnoreCase("no") || str.equalsIgnoreCase("off")) {
+    value = false;
+    return true;
+  }
+  return false;
+}
+
+static inline int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/**
+ * Decodes a part of the query string into dest, which must have room for str.length() characters.
+ * "%xx" becomes the character with the hex code xx, '+' becomes a space. Invalid escape sequences
+ * are copied as they are. Returns the length of the decoded string.
+ */
+size_t ResourceParameters::decode(HTTPSpan const &str, char * dest) {
+  const char * data = str.data();
+  size_t length = str.length();
+  size_t out = 0;
+  for(size_t i = 0; i < length; i++) {
+    char c = data[i];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && i + 2 < length) {
+      int hi = hexValue(data[i+1]);
+      int lo = hexValue(data[i+2]);
+      if (hi >= 0 && lo >= 0) {
+        c = (char)((hi << 4) | lo);
+        i += 2;
+      }
+    }
+    dest[out++] = c;
+  }
+  return out;
+}
+
+/**
+ * Splits the query string into parameters. Names are decoded right away, as they are compared for
+ * each lookup. Values are decoded when they are accessed.
+ */
+void ResourceParameters::parseQueryString() {
+  if (_queryParsed) {
+    return;
+  }
+  _queryParsed = true;
+  const char * pos = _queryString.data();
+  const char * end = pos + _queryString.length();
+  while(pos < end) {
+    // Parameters are separated by '&'
+    const char * paramEnd = (const char *)memchr(pos, '&', end - pos);
+    if (paramEnd == NULL) {
+      paramEnd = end;
+    }
+    if (paramEnd > pos) {
+      // Use empty string if only name is set. /foo?bar&baz=1 will return "" for bar
+      const char * split = (const char *)memchr(pos, '=', paramEnd - pos);
+      RequestParam param;
+      if (split == NULL) {
+        param.name = decodeSpan(HTTPSpan(pos, paramEnd - pos));
+        param.value = HTTPSpan();
+      } else {
+        param.name = decodeSpan(HTTPSpan(pos, split - pos));
+        param.value = HTTPSpan(split + 1, paramEnd - split - 1);
+      }
+      param.valueDecoded = false;
+      _reqParams.push_back(param);
+    }
+    pos = paramEnd + 1;
+  }
+}
+
+ResourceParameters::RequestParam * ResourceParameters::findRequestParameter(HTTPSpan const &name) {
+  parseQueryString();
+  for(size_t i = 0; i < _reqParams.size(); i++) {
+    if (_reqParams[i].name.equals(name)) {
+      return &_reqParams[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Returns the decoded string. Memory is only allocated if it contains escape sequences.
+ */
+HTTPSpan ResourceParameters::decodeSpan(HTTPSpan const &str) {
+  const char * data = str.data();
+  size_t i = 0;
+  while(i < str.length() && data[i] != '%' && data[i] != '+') {
+    i++;
+  }
+  if (i == str.length()) {
+    return str;
+  }
+  char * decoded = allocate(str.length());
+  return HTTPSpan(decoded, decode(str, decoded));
+}
+
+char * ResourceParameters::allocate(size_t length) {
+  if (_arena != NULL) {
+    return (char*)_arena->allocate(length);
+  }
+  char * data = new char[length];
+  _heapBlocks.push_back(data);
+  return data;
 }
 
 } /* namespace httpsserver */
@@ -11,6 +11,8 @@
 #include <utility>
 
 #include "util.hpp"
+#include "HTTPSpan.hpp"
+#include "RequestArena.hpp"
 
 namespace httpsserver {
 
@@ -18,26 +20,71 @@ struct requestparam_t {std::string name; std::string value;};
 
 /**
  * \brief Class used to handle access to the URL parameters
+ *
+ * The parameters are not copied. URL parameters and the query string are stored as references into
+ * the request string, which therefore has to outlive this object. The query string is only split
+ * into parameters when the first request parameter is accessed. Names and values are then
+ * percent-decoded ("%20" and "+" become a space).
+ *
+ * For a request, the parameters are stored in the connection's RequestArena and are only valid
+ * until the request is complete.
  */
 class ResourceParameters {
 public:
-  ResourceParameters();
+  ResourceParameters(RequestArena * arena = NULL);
   virtual ~ResourceParameters();
 
   bool isRequestParameterSet(std::string const &name);
   std::string getRequestParameter(std::string const &name);
-  uint16_t getRequestParameterInt(std::string const &name);
-  void setRequestParameter(std::string const &name, std::string const &value);
+  int32_t getRequestParameterInt(std::string const &name);
+  bool getRequestParameterSpan(HTTPSpan const &name, HTTPSpan &value);
+  bool getRequestParameterInt32(HTTPSpan const &name, int32_t &value);
+  bool getRequestParameterInt64(HTTPSpan const &name, int64_t &value);
+  bool getRequestParameterFloat(HTTPSpan const &name, float &value);
+  bool getRequestParameterBool(HTTPSpan const &name, bool &value);
+  void setRequestParameter(HTTPSpan const &name, HTTPSpan const &value);
+  void setQueryString(HTTPSpan const &query);
 
   std::string getUrlParameter(uint8_t idx);
-  uint16_t getUrlParameterInt(uint8_t idx);
+  int32_t getUrlParameterInt(uint8_t idx);
+  HTTPSpan getUrlParameterSpan(uint8_t idx);
+  bool getUrlParameterInt32(uint8_t idx, int32_t &value);
+  bool getUrlParameterInt64(uint8_t idx, int64_t &value);
+  bool getUrlParameterFloat(uint8_t idx, float &value);
+  bool getUrlParameterBool(uint8_t idx, bool &value);
   void resetUrlParameters();
   void setUrlParameterCount(uint8_t idx);
-  void setUrlParameter(uint8_t idx, std::string const &val);
+  void setUrlParameter(uint8_t idx, HTTPSpan const &val);
+
+  static bool parseInt64(HTTPSpan const &str, int64_t &value);
+  static bool parseFloat(HTTPSpan const &str, float &value);
+  static bool parseBool(HTTPSpan const &str, bool &value);
+  static size_t decode(HTTPSpan const &str, char * dest);
 
 private:
-  std::vector<std::string> _urlParams;
-  std::vector<std::pair<std::string, std::string>> _reqParams;
+  /** Parameter from the query string */
+  struct RequestParam {
+    // Name, already decoded
+    HTTPSpan name;
+    // Value, decoded on first access
+    HTTPSpan value;
+    bool valueDecoded;
+  };
+
+  void parseQueryString();
+  RequestParam * findRequestParameter(HTTPSpan const &name);
+  HTTPSpan decodeSpan(HTTPSpan const &str);
+  char * allocate(size_t length);
+
+  // Arena that holds the parameters, NULL if they are allocated on the heap
+  RequestArena * _arena;
+  std::vector<HTTPSpan, ArenaAllocator<HTTPSpan> > _urlParams;
+  // Query string without the '?', split into _reqParams on first access
+  HTTPSpan _queryString;
+  bool _queryParsed;
+  std::vector<RequestParam, ArenaAllocator<RequestParam> > _reqParams;
+  // Memory for decoded and copied strings if there is no arena
+  std::vector<char *> _heapBlocks;
 };
 
 } /* namespace httpsserver */
@@ -1,10 +1,13 @@
 #include "ResourceResolver.hpp"
+#include "HTTPConnection.hpp"
 
 namespace httpsserver {
 
 ResourceResolver::ResourceResolver() {
   _nodes = new std::vector<HTTPNode *>();
   _defaultNode = NULL;
+  _staticRoutes = NULL;
+  compileMiddleware();
 }
 
 ResourceResolver::~ResourceResolver() {
@@ -16,6 +19,7 @@ ResourceResolver::~ResourceResolver() {
  */
 void ResourceResolver::registerNode(HTTPNode *node) {
   _nodes->push_back(node);
+  _routes.insert(node);
 }
 
 /**
@@ -26,172 +30,141 @@ void ResourceResolver::unregisterNode(HTTPNode *node) {
 }
 
 void ResourceResolver::resolveNode(const std::string &method, const std::string &url, ResolvedResource &resolvedResource, HTTPNodeType nodeType) {
+  resolveNode(parseMethod(method), method, url, resolvedResource, nodeType);
+}
+
+/**
+ * Finds the node for a request whose method has already been parsed.
+ *
+ * If the path exists, but none of its nodes accepts the method, no node (not even the default node)
+ * is set and the methods of the path are stored as allowed methods in the resolved resource. A HEAD
+ * request that has no node of its own is resolved like a GET request, and GET allows HEAD.
+ *
+ * The parameters refer to url without copying it, so it must remain unchanged as long as the
+ * resolved resource is used.
+ */
+void ResourceResolver::resolveNode(HTTPMethodId methodId, const std::string &method, const std::string &url, ResolvedResource &resolvedResource, HTTPNodeType nodeType) {
   // Reset the resource
   resolvedResource.setMatchingNode(NULL);
+  resolvedResource.setStaticRoute(NULL);
   resolvedResource.setParams(NULL);
+  resolvedResource.setAllowedMethods(0);
 
   // Memory management of this object will be performed by the ResolvedResource instance
-  ResourceParameters * params = new ResourceParameters();
+  ResourceParameters * params = resolvedResource.createParams();
+  resolvedResource.setParams(params);
 
-  // Split URL in resource name and request params. Request params start after an optional '?'
+  // Split URL in resource name and request params. Request params start after an optional '?'.
+  // Both are passed to the params as spans. The query string is only parsed if the handler
+  // accesses the request params.
   size_t reqparamIdx = url.find('?');
 
-  // If no '?' is contained in url, 0:npos will return the string as it is
-  std::string resourceName = url.substr(0, reqparamIdx);
+  // If no '?' is contained in url, the resource name is the whole string
+  size_t resourceLength = reqparamIdx == std::string::npos ? url.length() : reqparamIdx;
+  const char * resourceName = url.data();
 
-  // Set request params in params object if a '?' exists
   if (reqparamIdx != std::string::npos) {
-    do {
-      // Drop the '?' or '&'
-      reqparamIdx += 1;
-
-      // Parameters are separated by '&'
-      size_t nextparamIdx = url.find('&', reqparamIdx);
-
-      // Get the "name=value" string
-      std::string param = url.substr(reqparamIdx, nextparamIdx - reqparamIdx);
-
-      // Find the position where the string has to be split
-      size_t nvSplitIdx = param.find('=');
-
-      // Use empty string if only name is set. /foo?bar&baz=1 will return "" for bar
-      std::string name  = param.substr(0, nvSplitIdx);
-      std::string value = "";
-      if (nvSplitIdx != std::string::npos) {
-        // TODO: There may be url encoding in here.
-        value = param.substr(nvSplitIdx+1);
-      }
-
-      // Now we finally have name and value.
-      params->setRequestParameter(name, value);
-
-      // Update reqparamIdx
-      reqparamIdx = nextparamIdx;
-
-    } while(reqparamIdx != std::string::npos);
+    params->setQueryString(HTTPSpan(url.data() + reqparamIdx + 1, url.length() - reqparamIdx - 1));
   }
 
-
-  // Check whether a resource matches
-  for(std::vector<HTTPNode*>::iterator node = _nodes->begin(); node != _nodes->end(); ++node) {
-    params->resetUrlParameters();
-    if ((*node)->_nodeType==nodeType) {
-      if (
-        // For handler functions, check the method declared with the node
-        ((*node)->_nodeType==HANDLER_CALLBACK && ((ResourceNode*)*node)->_method == method) ||
-        // For websockets, the specification says that GET is the only choice
-        ((*node)->_nodeType==WEBSOCKET && method=="GET")
-      ) {
-        const std::string nodepath = ((*node)->_path);
-        if (!((*node)->hasUrlParameter())) {
-          HTTPS_LOGD("Testing simple match on %s", nodepath.c_str());
-
-          // Simple matching, the node does not contain any resource parameters
-          if (nodepath == resourceName) {
-            resolvedResource.setMatchingNode(*node);
-            HTTPS_LOGD("It's a match! Path: %s", nodepath.c_str());
-            break;
-          }
-        } else {
-          HTTPS_LOGD("Testing parameter match on %s", nodepath.c_str());
-
-          // Advanced matching, we need to align the /?/ parts.
-          bool didMatch = true;
-          size_t urlIdx = 0; // Pointer how far the input url is processed
-          size_t nodeIdx = 0; // Pointer how far the node url is processed
-          for (int pIdx = 0; didMatch && pIdx < (*node)->getUrlParamCount(); pIdx++) {
-            size_t pOffset = (*node)->getParamIdx(pIdx);
-
-            // First step: Check static part
-            size_t staticLength = pOffset-nodeIdx;
-            if (nodepath.substr(nodeIdx, staticLength).compare(resourceName.substr(urlIdx, staticLength))!=0) {
-              // static part did not match
-              didMatch = false;
-              HTTPS_LOGD("No match on static part %d", pIdx);
-            } else {
-              // static part did match, increase pointers
-              nodeIdx += staticLength + 1; // +1 to take care of the '*' placeholder.
-              urlIdx  += staticLength; // The pointer should now point to the begin of the static part
-
-              // Second step: Grab the parameter value
-              if (nodeIdx == nodepath.length()) {
-                // Easy case: parse until end of string
-                params->setUrlParameter(pIdx, resourceName.substr(urlIdx));
-              } else {
-                // parse until first char after the placeholder
-                char terminatorChar = nodepath[nodeIdx];
-                size_t terminatorPosition = resourceName.find(terminatorChar, urlIdx);
-                if (terminatorPosition != std::string::npos) {
-                  // We actually found the terminator
-                  size_t dynamicLength = terminatorPosition-urlIdx;
-                  params->setUrlParameter(pIdx, resourceName.substr(urlIdx, dynamicLength));
-                  urlIdx = urlIdx + dynamicLength;
-                } else {
-                  // We did not find the terminator
-                  didMatch = false;
-                  HTTPS_LOGD("No match on dynamic part %d", pIdx);
-                }
-              }
-            } // static part did match
-          } // placeholder loop
-
-          // If there is some final static part to process
-          if (didMatch && nodeIdx < nodepath.length()) {
-            size_t staticLength = nodepath.length()-nodeIdx;
-            if (nodepath.substr(nodeIdx, staticLength).compare(url.substr(urlIdx, staticLength))!=0) {
-              didMatch = false;
-              HTTPS_LOGD("No match, final static part did not match");
-            } else {
-              urlIdx += staticLength;
-              // If there is some string remaining in the url that did not match
-              if (urlIdx < resourceName.length()) {
-                didMatch = false;
-                HTTPS_LOGD("No match, URL is longer than final static part");
-              }
-            }
-          }
-
-          // Every check worked, so the full url matches and the params are set
-          if (didMatch) {
-            resolvedResource.setMatchingNode(*node);
-            HTTPS_LOGD("It's a match!");
-            break;
-          }
-
-        } // static/dynamic url
-      } // method check
-    } // node type check
-  } // resource node for loop
+  HTTPMethodMask allowedMethods = 0;
+  HTTPSpan path(resourceName, resourceLength);
+  bool found = matchPath(methodId, method, path, nodeType, resolvedResource, &allowedMethods);
+  if (!found && methodId == METHOD_HEAD && (allowedMethods & METHOD_GET) != 0) {
+    // The handler for GET answers the request, the body of its response is omitted
+    found = matchPath(METHOD_GET, "GET", path, nodeType, resolvedResource, NULL);
+  }
+  if (found) {
+    return;
+  }
+  if (allowedMethods != 0) {
+    HTTPS_LOGD("Method not allowed for the path");
+    if ((allowedMethods & METHOD_GET) != 0) {
+      allowedMethods |= METHOD_HEAD;
+    }
+    resolvedResource.setAllowedMethods(allowedMethods);
+  }
 
   // If the resource did not match, configure the default resource
-  if (!resolvedResource.didMatch() && _defaultNode != NULL) {
+  if (!resolvedResource.didMatch() && allowedMethods == 0 && _defaultNode != NULL) {
     params->resetUrlParameters();
     resolvedResource.setMatchingNode(_defaultNode);
   }
 
-  // If resolving did work, set the params, otherwise delete them
-  if (resolvedResource.didMatch()) {
-    // The resolvedResource now takes care of memory management for the params
-    resolvedResource.setParams(params);
-  } else {
-    delete params;
+  // If resolving did not work, there are no params (this deletes them if they are on the heap)
+  if (!resolvedResource.didMatch()) {
+    resolvedResource.setParams(NULL);
+  }
+}
+
+/**
+ * Searches the static routes first, then the trie, and stores the match in the resolved resource. Both
+ * set the URL parameters of the match. Returns false if nothing matches.
+ */
+bool ResourceResolver::matchPath(HTTPMethodId methodId, HTTPSpan const &method, HTTPSpan const &path, HTTPNodeType nodeType,
+    ResolvedResource &resolvedResource, HTTPMethodMask * allowedMethods) {
+  ResourceParameters * params = resolvedResource.getParams();
+  if (_staticRoutes != NULL && nodeType == HANDLER_CALLBACK) {
+    const StaticRoute * route = _staticRoutes->match(methodId, path, params, allowedMethods);
+    if (route != NULL) {
+      HTTPS_LOGD("It's a match! Static path: %s", route->_path);
+      resolvedResource.setStaticRoute(route);
+      return true;
+    }
+  }
+  HTTPNode * node = _routes.match(methodId, method, path, nodeType, params, allowedMethods);
+  if (node != NULL) {
+    HTTPS_LOGD("It's a match! Path: %s", node->_path.c_str());
+    resolvedResource.setMatchingNode(node);
+    return true;
   }
+  return false;
 }
 
 void ResourceResolver::addMiddleware(const HTTPSMiddlewareFunction * mwFunction) {
   _middleware.push_back(mwFunction);
+  compileMiddleware();
 }
 
 void ResourceResolver::removeMiddleware(const HTTPSMiddlewareFunction * mwFunction) {
   _middleware.erase(std::remove(_middleware.begin(), _middleware.end(), mwFunction), _middleware.end());
+  compileMiddleware();
 }
 
-const std::vector<HTTPSMiddlewareFunction*> ResourceResolver::getMiddleware() {
+const std::vector<HTTPSMiddlewareFunction*> &ResourceResolver::getMiddleware() {
   return _middleware;
 }
 
+const MiddlewareChain * ResourceResolver::getMiddlewareChain() {
+  return &_middlewareChain;
+}
+
+/**
+ * Rebuilds the chain that is run for each request. The internal validation middleware is always
+ * called first.
+ */
+void ResourceResolver::compileMiddleware() {
+  std::vector<HTTPSMiddlewareFunction*> chain;
+  chain.push_back(&validationMiddleware);
+  chain.insert(chain.end(), _middleware.begin(), _middleware.end());
+  _middlewareChain.compile(chain);
+}
+
+/**
+ * Sets the node that handles requests for paths that no node matches. It is not used for a path that
+ * exists with other methods, such requests are answered with 405 Method Not Allowed.
+ */
 void ResourceResolver::setDefaultNode(HTTPNode * defaultNode) {
   _defaultNode = defaultNode;
 }
 
+/**
+ * Sets routes that have been defined at compile time (see StaticRouteTable). They are checked
+ * before the registered nodes, so a matching route wins over a node even if the node's path is
+ * more specific. The table is not copied, so it should be declared constexpr.
+ */
+void ResourceResolver::setStaticRoutes(const StaticRouteTable * routes) {
+  _staticRoutes = routes;
+}
+
 }
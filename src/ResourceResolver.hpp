@@ -13,6 +13,9 @@
 #include "ResourceNode.hpp"
 #include "ResolvedResource.hpp"
 #include "HTTPMiddlewareFunction.hpp"
+#include "MiddlewareChain.hpp"
+#include "RouteTrie.hpp"
+#include "StaticRouteTable.hpp"
 
 namespace httpsserver {
 
@@ -27,23 +30,36 @@ public:
   void registerNode(HTTPNode *node);
   void unregisterNode(HTTPNode *node);
   void setDefaultNode(HTTPNode *node);
+  void setStaticRoutes(const StaticRouteTable * routes);
   void resolveNode(const std::string &method, const std::string &url, ResolvedResource &resolvedResource, HTTPNodeType nodeType);
+  void resolveNode(HTTPMethodId methodId, const std::string &method, const std::string &url, ResolvedResource &resolvedResource, HTTPNodeType nodeType);
 
   /** Add a middleware function to the end of the middleware function chain. See HTTPSMiddlewareFunction.hpp for details. */
   void addMiddleware(const HTTPSMiddlewareFunction * mwFunction);
   /** Remove a specific function from the middleware function chain. */
   void removeMiddleware(const HTTPSMiddlewareFunction * mwFunction);
   /** Get the current middleware chain with a resource function at the end */
-  const std::vector<HTTPSMiddlewareFunction*> getMiddleware();
+  const std::vector<HTTPSMiddlewareFunction*> &getMiddleware();
+  /** Get the compiled middleware chain, including the internal validation middleware */
+  const MiddlewareChain * getMiddlewareChain();
 
 private:
+  void compileMiddleware();
+  bool matchPath(HTTPMethodId methodId, HTTPSpan const &method, HTTPSpan const &path, HTTPNodeType nodeType,
+    ResolvedResource &resolvedResource, HTTPMethodMask * allowedMethods);
 
   // This vector holds all nodes (with callbacks) that are registered
   std::vector<HTTPNode*> * _nodes;
   HTTPNode * _defaultNode;
+  // Routes defined at compile time, checked before the nodes. May be NULL.
+  const StaticRouteTable * _staticRoutes;
+  // The paths of the nodes, used to find the matching node for a request
+  RouteTrie _routes;
 
   // Middleware functions, if any are registered. Will be called in order of the vector.
-  std::vector<const HTTPSMiddlewareFunction*> _middleware;
+  std::vector<HTTPSMiddlewareFunction*> _middleware;
+  // The chain that is run for each request, rebuilt if _middleware changes
+  MiddlewareChain _middlewareChain;
 };
 
 } /* namespace httpsserver */
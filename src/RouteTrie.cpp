@@ -0,0 +1,225 @@
+#include "RouteTrie.hpp"
+
+namespace httpsserver {
+
+RouteTrie::RouteTrie() {
+  _root = createNode("", 0);
+}
+
+RouteTrie::~RouteTrie() {
+  deleteNode(_root);
+}
+
+/**
+ * Adds a node to the trie. The node itself remains owned by the caller.
+ */
+void RouteTrie::insert(HTTPNode * node) {
+  const std::string &path = node->_path;
+  Node * current = _root;
+  size_t staticStart = 0;
+  // Parameters are defined like in HTTPNode: A '*' that directly follows a '/'. It may be followed
+  // by the type of the parameter.
+  for(size_t i = 1; i < path.length(); i++) {
+    if (path[i] == '*' && path[i-1] == '/') {
+      current = insertStatic(current, path.data() + staticStart, i - staticStart);
+      URLParamConstraint constraint;
+      size_t specLength = URLParamConstraint::parse(path.data() + i + 1, path.length() - i - 1, constraint);
+      current = insertParam(current, constraint);
+      staticStart = i + 1 + specLength;
+      i += specLength;
+    }
+  }
+  current = insertStatic(current, path.data() + staticStart, path.length() - staticStart);
+  current->routes.push_back(node);
+}
+
+/**
+ * Returns the node that matches the path, the method and the node type, or NULL if there is none.
+ *
+ * The URL parameters of the matching node are stored in params. Nothing is allocated on the way.
+ *
+ * If allowedMethods is given, the methods of the nodes that match the path and the node type but
+ * not the method are added to it. If no node matches, but the mask is not empty, the resource
+ * exists and the request can be answered with 405 Method Not Allowed.
+ */
+HTTPNode * RouteTrie::match(HTTPMethodId methodId, HTTPSpan const &method, HTTPSpan const &path, HTTPNodeType nodeType,
+    ResourceParameters * params, HTTPMethodMask * allowedMethods) const {
+  Lookup lookup;
+  lookup.path = path.data();
+  lookup.length = path.length();
+  lookup.methodId = methodId;
+  lookup.method = method;
+  lookup.nodeType = nodeType;
+  lookup.params = params;
+  lookup.allowedMethods = allowedMethods;
+  return matchNode(lookup, _root, 0, NULL, 0);
+}
+
+RouteTrie::Node * RouteTrie::createNode(const char * prefix, size_t length) {
+  Node * node = new Node();
+  node->prefix.assign(prefix, length);
+  return node;
+}
+
+void RouteTrie::deleteNode(Node * node) {
+  for(size_t i = 0; i < node->children.size(); i++) {
+    deleteNode(node->children[i]);
+  }
+  for(size_t i = 0; i < node->params.size(); i++) {
+    deleteNode(node->params[i]);
+  }
+  delete node;
+}
+
+/**
+ * Adds the static string below the node, splitting existing nodes where it diverges from them.
+ * Returns the node where the string ends.
+ */
+RouteTrie::Node * RouteTrie::insertStatic(Node * node, const char * str, size_t length) {
+  while(length > 0) {
+    size_t childIdx = 0;
+    while(childIdx < node->children.size() && node->children[childIdx]->prefix[0] != str[0]) {
+      childIdx++;
+    }
+    if (childIdx == node->children.size()) {
+      Node * child = createNode(str, length);
+      node->children.push_back(child);
+      return child;
+    }
+
+    Node * child = node->children[childIdx];
+    size_t common = 1;
+    while(common < length && common < child->prefix.length() && child->prefix[common] == str[common]) {
+      common++;
+    }
+    if (common < child->prefix.length()) {
+      // The string diverges within the prefix of the child, so it is split in two nodes
+      Node * split = createNode(child->prefix.data(), common);
+      child->prefix.erase(0, common);
+      split->children.push_back(child);
+      node->children[childIdx] = split;
+      child = split;
+    }
+    node = child;
+    str += common;
+    length -= common;
+  }
+  return node;
+}
+
+/**
+ * Returns the parameter node with the constraint below the node, creating it if required
+ */
+RouteTrie::Node * RouteTrie::insertParam(Node * node, URLParamConstraint const &constraint) {
+  size_t idx = 0;
+  while(idx < node->params.size() && !node->params[idx]->constraint.equals(constraint)) {
+    idx++;
+  }
+  if (idx < node->params.size()) {
+    return node->params[idx];
+  }
+  Node * param = createNode("", 0);
+  param->constraint = constraint;
+  if (constraint.getType() != URLParamConstraint::PARAM_ANY && !node->params.empty() &&
+      node->params.back()->constraint.getType() == URLParamConstraint::PARAM_ANY) {
+    // Parameters without a type match anything, so they are tried last
+    node->params.insert(node->params.end() - 1, param);
+  } else {
+    node->params.push_back(param);
+  }
+  return param;
+}
+
+HTTPNode * RouteTrie::matchNode(const Lookup &lookup, const Node * node, size_t pos, const Capture * captures, uint8_t captureCount) {
+  size_t prefixLength = node->prefix.length();
+  if (lookup.length - pos < prefixLength || memcmp(lookup.path + pos, node->prefix.data(), prefixLength) != 0) {
+    return NULL;
+  }
+  pos += prefixLength;
+
+  if (pos == lookup.length) {
+    HTTPNode * route = selectRoute(lookup, node, captures, captureCount);
+    if (route != NULL) {
+      return route;
+    }
+  } else {
+    // At most one static child can start with the next character
+    char next = lookup.path[pos];
+    for(size_t i = 0; i < node->children.size(); i++) {
+      if (node->children[i]->prefix[0] == next) {
+        HTTPNode * route = matchNode(lookup, node->children[i], pos, captures, captureCount);
+        if (route != NULL) {
+          return route;
+        }
+        break;
+      }
+    }
+  }
+
+  for(size_t i = 0; i < node->params.size(); i++) {
+    HTTPNode * route = matchParam(lookup, node->params[i], pos, captures, captureCount);
+    if (route != NULL) {
+      return route;
+    }
+  }
+  return NULL;
+}
+
+HTTPNode * RouteTrie::matchParam(const Lookup &lookup, const Node * param, size_t pos, const Capture * captures, uint8_t captureCount) {
+  Capture capture;
+  capture.prev = captures;
+
+  // The parameter ends before the first occurrence of the character that follows it
+  const char * start = lookup.path + pos;
+  for(size_t i = 0; i < param->children.size(); i++) {
+    const char * end = (const char *)memchr(start, param->children[i]->prefix[0], lookup.length - pos);
+    if (end != NULL) {
+      capture.value = HTTPSpan(start, end - start);
+      if (!param->constraint.accepts(capture.value)) {
+        continue;
+      }
+      HTTPNode * route = matchNode(lookup, param->children[i], end - lookup.path, &capture, captureCount + 1);
+      if (route != NULL) {
+        return route;
+      }
+    }
+  }
+
+  // A parameter at the end of a node's path takes the rest of the path
+  capture.value = HTTPSpan(start, lookup.length - pos);
+  if (!param->constraint.accepts(capture.value)) {
+    return NULL;
+  }
+  return selectRoute(lookup, param, &capture, captureCount + 1);
+}
+
+/**
+ * Returns the first node that ends at the trie node and accepts the request. Its parameters are
+ * stored in lookup.params.
+ */
+HTTPNode * RouteTrie::selectRoute(const Lookup &lookup, const Node * node, const Capture * captures, uint8_t captureCount) {
+  for(size_t i = 0; i < node->routes.size(); i++) {
+    HTTPNode * route = node->routes[i];
+    if (route->_nodeType != lookup.nodeType) {
+      continue;
+    }
+    bool accepted = lookup.methodId != METHOD_UNKNOWN ?
+      (route->_methods & lookup.methodId) != 0 :
+      // Nodes for methods that the server does not know store the name of the method only
+      (route->_methods == 0 && route->_nodeType == HANDLER_CALLBACK && lookup.method.equals(((ResourceNode*)route)->_method));
+    if (!accepted) {
+      if (lookup.allowedMethods != NULL) {
+        *lookup.allowedMethods |= route->_methods;
+      }
+      continue;
+    }
+    uint8_t idx = captureCount;
+    for(const Capture * capture = captures; capture != NULL; capture = capture->prev) {
+      lookup.params->setUrlParameter(--idx, capture->value);
+    }
+    return route;
+  }
+  return NULL;
+}
+
+} /* namespace httpsserver */
@@ -0,0 +1,96 @@
+#ifndef SRC_ROUTETRIE_HPP_
+#define SRC_ROUTETRIE_HPP_
+
+#include <Arduino.h>
+
+#include <string>
+// Arduino declares it's own min max, incompatible with the stl...
+#undef min
+#undef max
+#include <vector>
+
+#include "HTTPSServerConstants.hpp"
+#include "HTTPSpan.hpp"
+#include "HTTPMethod.hpp"
+#include "HTTPNode.hpp"
+#include "ResourceNode.hpp"
+#include "ResourceParameters.hpp"
+#include "URLParamConstraint.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Compressed radix trie that maps request paths to HTTPNodes
+ *
+ * The paths of the nodes are split into static parts and URL parameters (a '*' after a '/'). Static parts are
+ * stored in a radix tree, so a lookup only compares each character of the path once, no matter how
+ * many nodes are registered. Each trie node stores the HTTPNodes whose path ends there, so that the
+ * method and node type are only checked for the paths that match. Methods are compared as bitmasks
+ * (see HTTPMethodId), only methods that the server does not know are compared by their name.
+ *
+ * A parameter extends to the next occurrence of the character that follows the placeholder in the
+ * node's path (usually '/'), or to the end of the path if the placeholder is the last character. If
+ * the placeholder has a type (see URLParamConstraint), the value is checked before the lookup
+ * descends any further. At each position, static parts are tried before parameters with a type,
+ * and those before parameters without a type. Nodes with the same path are tried in the order they
+ * have been registered.
+ *
+ * Lookups do not modify the trie, so several workers can use it at the same time.
+ */
+class RouteTrie {
+public:
+  RouteTrie();
+  virtual ~RouteTrie();
+
+  void insert(HTTPNode * node);
+  HTTPNode * match(HTTPMethodId methodId, HTTPSpan const &method, HTTPSpan const &path, HTTPNodeType nodeType,
+    ResourceParameters * params, HTTPMethodMask * allowedMethods = NULL) const;
+
+private:
+  struct Node {
+    // Static characters of this node
+    std::string prefix;
+    // Nodes with static parts that follow this node, with distinct first characters
+    std::vector<Node*> children;
+    // Nodes for URL parameters that follow this node, the ones without a type last
+    std::vector<Node*> params;
+    // Type of the parameter if this node is a parameter node
+    URLParamConstraint constraint;
+    // HTTPNodes whose path ends here, in the order of registration
+    std::vector<HTTPNode*> routes;
+  };
+
+  /** Parameter value captured during a lookup, linked to the previous parameter on the stack */
+  struct Capture {
+    HTTPSpan value;
+    const Capture * prev;
+  };
+
+  /** Arguments of a lookup that do not change during the recursion */
+  struct Lookup {
+    const char * path;
+    size_t length;
+    HTTPMethodId methodId;
+    // Only used if methodId is METHOD_UNKNOWN
+    HTTPSpan method;
+    HTTPNodeType nodeType;
+    ResourceParameters * params;
+    // Collects the methods of nodes that match the path, but not the method. May be NULL.
+    HTTPMethodMask * allowedMethods;
+  };
+
+  static Node * createNode(const char * prefix, size_t length);
+  static void deleteNode(Node * node);
+  static Node * insertStatic(Node * node, const char * str, size_t length);
+  static Node * insertParam(Node * node, URLParamConstraint const &constraint);
+
+  static HTTPNode * matchNode(const Lookup &lookup, const Node * node, size_t pos, const Capture * captures, uint8_t captureCount);
+  static HTTPNode * matchParam(const Lookup &lookup, const Node * param, size_t pos, const Capture * captures, uint8_t captureCount);
+  static HTTPNode * selectRoute(const Lookup &lookup, const Node * node, const Capture * captures, uint8_t captureCount);
+
+  Node * _root;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_ROUTETRIE_HPP_ */
@@ -0,0 +1,127 @@
+#ifndef SRC_STATICROUTE_HPP_
+#define SRC_STATICROUTE_HPP_
+
+#include <Arduino.h>
+
+#include "HTTPMethod.hpp"
+#include "HTTPSCallbackFunction.hpp"
+#include "URLParamConstraint.hpp"
+
+// Maximum number of URL parameters of a StaticRoute. The initializer of StaticRoute::_params has
+// one entry for each, so this is no build flag.
+#define HTTPS_STATIC_ROUTE_MAX_PARAMS 4
+
+namespace httpsserver {
+
+/**
+ * \brief Route that is defined at compile time, see StaticRouteTable
+ *
+ * A StaticRoute is a literal type, so an array of routes can be declared constexpr. The compiler
+ * then evaluates the constructors, including the analysis of the path, and the array is placed in
+ * flash without any code running at startup:
+ *
+ * ```C++
+ * constexpr StaticRoute ROUTES[] = {
+ *   StaticRoute("/", METHOD_GET | METHOD_HEAD, &handleRoot),
+ *   StaticRoute("/settings", METHOD_POST, &handleSettings, "admin")
+ * };
+ * ```
+ *
+ * Paths use the same syntax as for HTTPNode: They should start with a slash, and a '*' that follows
+ * a slash is a URL parameter, which may have a type (see URLParamConstraint). The types are parsed
+ * by the compiler as well. A route can have up to HTTPS_STATIC_ROUTE_MAX_PARAMS parameters, more
+ * fail to compile in a constexpr array. Path and tag must be string literals (or other strings with
+ * static storage duration).
+ */
+struct StaticRoute {
+  /** URL parameter of the route */
+  struct Param {
+    /** Position of the '*' in _path */
+    size_t start;
+    /** Position of the first character in _path after the parameter and its type */
+    size_t end;
+    /** Type of the parameter */
+    URLParamConstraint constraint;
+  };
+
+  constexpr StaticRoute(const char * path, HTTPMethodMask methods, const HTTPSCallbackFunction * callback, const char * tag = ""):
+    _path(path),
+    _pathLength(length(path)),
+    _staticLength(staticLength(path)),
+    _paramCount(countParams(path, length(path)) <= HTTPS_STATIC_ROUTE_MAX_PARAMS ?
+      countParams(path, length(path)) : tooManyURLParameters()),
+    _params{
+      param(path, length(path), 0),
+      param(path, length(path), 1),
+      param(path, length(path), 2),
+      param(path, length(path), 3)
+    },
+    _methods(methods),
+    _callback(callback),
+    _tag(tag) {}
+
+  /** The path of the route */
+  const char * const _path;
+  /** Length of _path */
+  const size_t _pathLength;
+  /** Length of the part of _path that precedes the first URL parameter */
+  const size_t _staticLength;
+  /** Number of URL parameters in _path */
+  const uint8_t _paramCount;
+  /** The first _paramCount entries describe the URL parameters of _path */
+  const Param _params[HTTPS_STATIC_ROUTE_MAX_PARAMS];
+  /** The methods that the route accepts */
+  const HTTPMethodMask _methods;
+  /** The handler function */
+  const HTTPSCallbackFunction * const _callback;
+  /** Tag for middleware and handler functions, like HTTPNode::_tag */
+  const char * const _tag;
+
+private:
+  // C++11 allows only a single return statement in constexpr functions, hence the recursion
+  static constexpr bool isParam(const char * s, size_t i) {
+    return s[i] == '*' && i > 0 && s[i-1] == '/';
+  }
+
+  static constexpr size_t length(const char * s, size_t i = 0) {
+    return s[i] == 0 ? i : length(s, i + 1);
+  }
+
+  static constexpr size_t staticLength(const char * s, size_t i = 0) {
+    return (s[i] == 0 || isParam(s, i)) ? i : staticLength(s, i + 1);
+  }
+
+  /** Returns the position after the parameter whose '*' is at i, skipping its type */
+  static constexpr size_t paramEnd(const char * s, size_t len, size_t i) {
+    return i + 1 + URLParamConstraint::specLength(s + i + 1, len - i - 1);
+  }
+
+  static constexpr uint8_t countParams(const char * s, size_t len, size_t i = 0) {
+    return i >= len ? 0 : (isParam(s, i) ? 1 + countParams(s, len, paramEnd(s, len, i)) : countParams(s, len, i + 1));
+  }
+
+  /** Returns the position of the '*' of parameter n, or len if there are fewer parameters */
+  static constexpr size_t paramStart(const char * s, size_t len, uint8_t n, size_t i = 0) {
+    return i >= len ? len :
+      (isParam(s, i) ? (n == 0 ? i : paramStart(s, len, n - 1, paramEnd(s, len, i))) : paramStart(s, len, n, i + 1));
+  }
+
+  static constexpr Param param(const char * s, size_t len, uint8_t n) {
+    return paramStart(s, len, n) == len ? Param{len, len, URLParamConstraint()} :
+      Param{
+        paramStart(s, len, n),
+        paramEnd(s, len, paramStart(s, len, n)),
+        URLParamConstraint::fromSpec(s + paramStart(s, len, n) + 1, len - paramStart(s, len, n) - 1)
+      };
+  }
+
+  // Not constexpr, so a constexpr route with too many parameters does not compile. Routes that are
+  // created at runtime treat the parameters beyond the limit as literal text.
+  static uint8_t tooManyURLParameters() {
+    return HTTPS_STATIC_ROUTE_MAX_PARAMS;
+  }
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_STATICROUTE_HPP_ */
@@ -0,0 +1,86 @@
+#include "StaticRouteTable.hpp"
+
+namespace httpsserver {
+
+/**
+ * Returns the first route that matches the path and the method, or NULL if there is none.
+ *
+ * The URL parameters of the matching route are stored in params. If allowedMethods is given, the
+ * methods of routes that match the path but not the method are added to it, like for
+ * RouteTrie::match().
+ */
+const StaticRoute * StaticRouteTable::match(HTTPMethodId methodId, HTTPSpan const &path, ResourceParameters * params,
+    HTTPMethodMask * allowedMethods) const {
+  HTTPSpan values[HTTPS_STATIC_ROUTE_MAX_PARAMS];
+  for(size_t i = 0; i < _count; i++) {
+    const StaticRoute &route = _routes[i];
+    bool methodMatches = (route._methods & methodId) != 0;
+    // The path only needs to be checked for another method if the allowed methods are collected
+    if (!methodMatches && allowedMethods == NULL) {
+      continue;
+    }
+    if (!matchPath(route, path, values)) {
+      continue;
+    }
+    if (!methodMatches) {
+      *allowedMethods |= route._methods;
+      continue;
+    }
+    for(uint8_t p = 0; p < route._paramCount; p++) {
+      params->setUrlParameter(p, values[p]);
+    }
+    return &route;
+  }
+  return NULL;
+}
+
+/**
+ * Checks whether the path matches the route and stores the values of its URL parameters in values.
+ * A parameter extends to the next occurrence of the character that follows it in the route's path,
+ * or to the end of the path if it is the last character. Its value must match the type of the
+ * parameter, if there is one (see URLParamConstraint). The positions and types of the parameters
+ * have been determined by the compiler, so the route's path is not parsed again.
+ */
+bool StaticRouteTable::matchPath(const StaticRoute &route, HTTPSpan const &path, HTTPSpan * values) {
+  const char * pattern = route._path;
+  const char * data = path.data();
+  size_t length = path.length();
+
+  // Check the static prefix first, which rules out most of the routes
+  size_t patternIdx = route._staticLength;
+  if (length < patternIdx || memcmp(data, pattern, patternIdx) != 0) {
+    return false;
+  }
+
+  size_t pathIdx = patternIdx;
+  for(uint8_t i = 0; i < route._paramCount; i++) {
+    const StaticRoute::Param &param = route._params[i];
+    // Static text between the previous parameter and this one
+    size_t textLength = param.start - patternIdx;
+    if (length - pathIdx < textLength || memcmp(data + pathIdx, pattern + patternIdx, textLength) != 0) {
+      return false;
+    }
+    pathIdx += textLength;
+
+    size_t valueEnd = length;
+    if (param.end < route._pathLength) {
+      const char * end = (const char *)memchr(data + pathIdx, pattern[param.end], length - pathIdx);
+      if (end == NULL) {
+        return false;
+      }
+      valueEnd = end - data;
+    }
+    values[i] = HTTPSpan(data + pathIdx, valueEnd - pathIdx);
+    if (!param.constraint.accepts(values[i])) {
+      return false;
+    }
+    pathIdx = valueEnd;
+    patternIdx = param.end;
+  }
+
+  // Static text after the last parameter
+  size_t textLength = route._pathLength - patternIdx;
+  return length - pathIdx == textLength && memcmp(data + pathIdx, pattern + patternIdx, textLength) == 0;
+}
+
+} /* namespace httpsserver */
@@ -0,0 +1,59 @@
+#ifndef SRC_STATICROUTETABLE_HPP_
+#define SRC_STATICROUTETABLE_HPP_
+
+#include <Arduino.h>
+
+#include "HTTPSServerConstants.hpp"
+#include "HTTPMethod.hpp"
+#include "HTTPSpan.hpp"
+#include "ResourceParameters.hpp"
+#include "StaticRoute.hpp"
+#include "URLParamConstraint.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Fixed set of routes that is created at compile time
+ *
+ * Firmware with a fixed API can declare its routes as a constexpr array of StaticRoute and wrap it
+ * in a constexpr table, which is then passed to ResourceResolver::setStaticRoutes():
+ *
+ * ```C++
+ * constexpr StaticRouteTable ROUTE_TABLE(ROUTES);
+ *
+ * void setup() {
+ *   server.setStaticRoutes(&ROUTE_TABLE);
+ * }
+ * ```
+ *
+ * Unlike ResourceNodes, the routes need no heap memory and no work at startup. The compiler computes
+ * the static prefix of each route and the positions and types of its URL parameters. A lookup
+ * compares the static prefix of each route first, and only routes with URL parameters are scanned
+ * further, without parsing their paths again. The routes are tried in the order of the array.
+ *
+ * Static routes always use handler functions. Websockets and validators (see
+ * HTTPNode::addURLParamValidator()) still require nodes.
+ */
+class StaticRouteTable {
+public:
+  template<size_t N>
+  constexpr StaticRouteTable(const StaticRoute (&routes)[N]):
+    _routes(routes),
+    _count(N) {}
+
+  const StaticRoute * match(HTTPMethodId methodId, HTTPSpan const &path, ResourceParameters * params,
+    HTTPMethodMask * allowedMethods = NULL) const;
+
+  constexpr size_t getCount() const { return _count; }
+  constexpr const StaticRoute * getRoute(size_t idx) const { return idx < _count ? &_routes[idx] : NULL; }
+
+private:
+  static bool matchPath(const StaticRoute &route, HTTPSpan const &path, HTTPSpan * values);
+
+  const StaticRoute * const _routes;
+  const size_t _count;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_STATICROUTETABLE_HPP_ */
@@ -0,0 +1,59 @@
+#include "Timer.hpp"
+
+namespace httpsserver {
+
+Timer::Timer():
+  _expires(0),
+  _slot(NULL),
+  _prev(NULL),
+  _next(NULL) {
+
+}
+
+Timer::Timer(std::function<void()> const &callback):
+  _callback(callback),
+  _expires(0),
+  _slot(NULL),
+  _prev(NULL),
+  _next(NULL) {
+
+}
+
+Timer::~Timer() {
+  cancel();
+}
+
+/**
+ * Sets the function that is called when the timer expires
+ */
+void Timer::setCallback(std::function<void()> const &callback) {
+  _callback = callback;
+}
+
+/**
+ * Returns true if the timer is scheduled and has not expired yet
+ */
+bool Timer::isScheduled() {
+  return _slot != NULL;
+}
+
+/**
+ * Removes the timer from its wheel. Does nothing if the timer is not scheduled.
+ */
+void Timer::cancel() {
+  if (_slot != NULL) {
+    if (_prev != NULL) {
+      _prev->_next = _next;
+    } else {
+      *_slot = _next;
+    }
+    if (_next != NULL) {
+      _next->_prev = _prev;
+    }
+    _slot = NULL;
+    _prev = NULL;
+    _next = NULL;
+  }
+}
+
+} /* namespace httpsserver */
@@ -0,0 +1,47 @@
+#ifndef SRC_TIMER_HPP_
+#define SRC_TIMER_HPP_
+
+#include <Arduino.h>
+
+#include <functional>
+
+namespace httpsserver {
+
+class TimerWheel;
+
+/**
+ * \brief A callback that is run by a TimerWheel after a given time
+ *
+ * Scheduling and cancelling a timer does not allocate memory, so a timer can be rescheduled as
+ * often as needed (e.g. to extend a timeout on each transmission). A timer is cancelled
+ * automatically when it is destroyed.
+ */
+class Timer {
+public:
+  Timer();
+  Timer(std::function<void()> const &callback);
+  virtual ~Timer();
+
+  void setCallback(std::function<void()> const &callback);
+  bool isScheduled();
+  void cancel();
+
+private:
+  friend class TimerWheel;
+
+  // Function that is called when the timer expires
+  std::function<void()> _callback;
+
+  // Tick of the wheel at which the timer expires
+  uint32_t _expires;
+
+  // The timers of a wheel slot form a doubly linked list. _slot points to the head of that list,
+  // or is NULL if the timer is not scheduled.
+  Timer ** _slot;
+  Timer * _prev;
+  Timer * _next;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_TIMER_HPP_ */
@@ -0,0 +1,139 @@
+#include "TimerWheel.hpp"
+
+namespace httpsserver {
+
+/**
+ * Creates an empty wheel. now is the current time (usually millis()), from which update() continues.
+ */
+TimerWheel::TimerWheel(unsigned long now) {
+  for(int level = 0; level < HTTPS_TIMER_WHEEL_LEVELS; level++) {
+    for(int slot = 0; slot < HTTPS_TIMER_WHEEL_SLOTS; slot++) {
+      _slots[level][slot] = NULL;
+    }
+  }
+  _currentTick = 0;
+  _currentTime = now;
+}
+
+TimerWheel::~TimerWheel() {
+  // Detach the remaining timers, so that they don't refer to the wheel anymore
+  for(int level = 0; level < HTTPS_TIMER_WHEEL_LEVELS; level++) {
+    for(int slot = 0; slot < HTTPS_TIMER_WHEEL_SLOTS; slot++) {
+      while(_slots[level][slot] != NULL) {
+        _slots[level][slot]->cancel();
+      }
+    }
+  }
+}
+
+/**
+ * Schedules the timer to expire after delay milliseconds. If the timer is already scheduled, it is
+ * moved to the new expiry time.
+ *
+ * The callback is called from update(), at most HTTPS_TIMER_RESOLUTION ms after the delay has passed.
+ */
+void TimerWheel::schedule(Timer * timer, unsigned long delay) {
+  timer->cancel();
+  // +1, as part of the current tick has already passed
+  timer->_expires = _currentTick + delay / HTTPS_TIMER_RESOLUTION + 1;
+  insert(timer);
+}
+
+/**
+ * Advances the wheel to the given time (usually millis()) and runs the callbacks of all timers
+ * that have expired until then.
+ */
+void TimerWheel::update(unsigned long now) {
+  // Unsigned arithmetic on 32 bit, so this is also correct if millis() has wrapped in between
+  uint32_t ticks = ((uint32_t)now - _currentTime) / HTTPS_TIMER_RESOLUTION;
+
+  // Nothing to do on the way if there are no timers
+  if (ticks > HTTPS_TIMER_WHEEL_SLOTS && isEmpty()) {
+    _currentTick += ticks;
+    _currentTime += ticks * HTTPS_TIMER_RESOLUTION;
+    return;
+  }
+
+  while(ticks > 0) {
+    _currentTime += HTTPS_TIMER_RESOLUTION;
+    ticks--;
+    tick();
+  }
+}
+
+void TimerWheel::insert(Timer * timer) {
+  uint32_t delta = timer->_expires - _currentTick;
+
+  // Find the lowest level that covers the expiry time
+  int level = 0;
+  uint32_t expires = timer->_expires;
+  while(level < HTTPS_TIMER_WHEEL_LEVELS - 1 && delta >= ((uint32_t)1 << ((level + 1) * HTTPS_TIMER_WHEEL_BITS))) {
+    level++;
+  }
+  uint32_t range = (uint32_t)1 << ((level + 1) * HTTPS_TIMER_WHEEL_BITS);
+  if (delta >= range) {
+    // Too far in the future. Park the timer in the last slot that is in range. When it is moved
+    // down from there, it is inserted again using its real expiry time.
+    expires = _currentTick + range - 1;
+  }
+
+  Timer ** slot = &_slots[level][(expires >> (level * HTTPS_TIMER_WHEEL_BITS)) & (HTTPS_TIMER_WHEEL_SLOTS - 1)];
+  timer->_slot = slot;
+  timer->_prev = NULL;
+  timer->_next = *slot;
+  if (*slot != NULL) {
+    (*slot)->_prev = timer;
+  }
+  *slot = timer;
+}
+
+bool TimerWheel::isEmpty() {
+  for(int level = 0; level < HTTPS_TIMER_WHEEL_LEVELS; level++) {
+    for(int slot = 0; slot < HTTPS_TIMER_WHEEL_SLOTS; slot++) {
+      if (_slots[level][slot] != NULL) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void TimerWheel::tick() {
+  _currentTick++;
+
+  // When a level has completed a rotation, the next slot of the level above is moved down
+  for(int level = 1; level < HTTPS_TIMER_WHEEL_LEVELS; level++) {
+    uint32_t shift = level * HTTPS_TIMER_WHEEL_BITS;
+    if ((_currentTick & (((uint32_t)1 << shift) - 1)) != 0) {
+      break;
+    }
+    cascade(level, (_currentTick >> shift) & (HTTPS_TIMER_WHEEL_SLOTS - 1));
+  }
+
+  // Take the list of expired timers out of the wheel. Callbacks may schedule or cancel any timer,
+  // including the ones in this list, so each timer is removed from the list before it is run.
+  Timer * expired = _slots[0][_currentTick & (HTTPS_TIMER_WHEEL_SLOTS - 1)];
+  _slots[0][_currentTick & (HTTPS_TIMER_WHEEL_SLOTS - 1)] = NULL;
+  for(Timer * timer = expired; timer != NULL; timer = timer->_next) {
+    timer->_slot = &expired;
+  }
+  while(expired != NULL) {
+    Timer * timer = expired;
+    timer->cancel();
+    if (timer->_callback) {
+      timer->_callback();
+    }
+  }
+}
+
+void TimerWheel::cascade(int level, int slot) {
+  Timer * timer = _slots[level][slot];
+  _slots[level][slot] = NULL;
+  while(timer != NULL) {
+    Timer * next = timer->_next;
+    insert(timer);
+    timer = next;
+  }
+}
+
+} /* namespace httpsserver */
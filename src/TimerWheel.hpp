@@ -0,0 +1,52 @@
+#ifndef SRC_TIMERWHEEL_HPP_
+#define SRC_TIMERWHEEL_HPP_
+
+#include <Arduino.h>
+
+#include "HTTPSServerConstants.hpp"
+#include "Timer.hpp"
+
+// Each level of the wheel has 2^HTTPS_TIMER_WHEEL_BITS slots
+#define HTTPS_TIMER_WHEEL_BITS   5
+#define HTTPS_TIMER_WHEEL_SLOTS  (1 << HTTPS_TIMER_WHEEL_BITS)
+#define HTTPS_TIMER_WHEEL_LEVELS 3
+
+namespace httpsserver {
+
+/**
+ * \brief Hierarchical timer wheel that runs Timers with a resolution of HTTPS_TIMER_RESOLUTION ms
+ *
+ * The first level has one slot per tick. Each further level has slots for whole rotations of the
+ * level below, and its timers are moved down when that level has rotated once. Scheduling,
+ * cancelling and expiring a timer therefore takes constant time, independent of the number of
+ * timers. With the default settings, the levels cover 0.32 s, 10 s and 5.4 min. Timers that
+ * expire later are kept in the last level until they come into range.
+ *
+ * The wheel does not run on its own, update() has to be called regularly. Time differences are
+ * calculated so that the wrap-around of millis() does not matter.
+ */
+class TimerWheel {
+public:
+  TimerWheel(unsigned long now = millis());
+  virtual ~TimerWheel();
+
+  void schedule(Timer * timer, unsigned long delay);
+  void update(unsigned long now);
+
+private:
+  void insert(Timer * timer);
+  bool isEmpty();
+  void tick();
+  void cascade(int level, int slot);
+
+  Timer * _slots[HTTPS_TIMER_WHEEL_LEVELS][HTTPS_TIMER_WHEEL_SLOTS];
+
+  // Current tick of the wheel
+  uint32_t _currentTick;
+  // Value of millis() that corresponds to _currentTick
+  uint32_t _currentTime;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_TIMERWHEEL_HPP_ */
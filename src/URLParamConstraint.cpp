@@ -0,0 +1,94 @@
+#include "URLParamConstraint.hpp"
+#include "HTTPSServerConstants.hpp"
+#include "ResourceParameters.hpp"
+
+namespace httpsserver {
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline bool isHexDigit(char c) {
+  if (isDigit(c)) {
+    return true;
+  }
+  // Lowercase only for the letters, as it would turn control characters into digits
+  c |= 0x20;
+  return c >= 'a' && c <= 'f';
+}
+
+/**
+ * Parses the type that follows the '*' of a URL parameter in a node's path. spec points to the
+ * character after the '*'. Returns the number of characters that belong to the type (including the
+ * braces) and stores it in constraint, or returns 0 if the parameter has no type.
+ *
+ * Text in braces that is no type is logged and left in the path as literal text.
+ */
+size_t URLParamConstraint::parse(const char * spec, size_t length, URLParamConstraint &constraint) {
+  constraint = fromSpec(spec, length);
+  size_t typeLength = specLength(spec, length);
+  if (typeLength == 0 && bracesLength(spec, length) > 0) {
+    HTTPS_LOGW("Unknown type of URL parameter: %.*s, treating it as text", (int)bracesLength(spec, length), spec);
+  }
+  return typeLength;
+}
+
+/**
+ * Checks whether the value of a URL parameter has the type. Nothing is copied.
+ */
+bool URLParamConstraint::accepts(HTTPSpan const &value) const {
+  const char * data = value.data();
+  size_t length = value.length();
+  switch(_type) {
+    case PARAM_ANY:
+      return true;
+    case PARAM_INT: {
+      int64_t v;
+      return ResourceParameters::parseInt64(value, v);
+    }
+    case PARAM_UINT: {
+      int64_t v;
+      return length > 0 && isDigit(data[0]) && ResourceParameters::parseInt64(value, v);
+    }
+    case PARAM_HEX:
+      for(size_t i = 0; i < length; i++) {
+        if (!isHexDigit(data[i])) {
+          return false;
+        }
+      }
+      return length > 0;
+    case PARAM_UUID:
+      if (length != 36) {
+        return false;
+      }
+      for(size_t i = 0; i < length; i++) {
+        bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? data[i] != '-' : !isHexDigit(data[i])) {
+          return false;
+        }
+      }
+      return true;
+    case PARAM_ENUM: {
+      const char * option = _values.data();
+      const char * valuesEnd = option + _values.length();
+      while(option <= valuesEnd) {
+        const char * optionEnd = (const char *)memchr(option, '|', valuesEnd - option);
+        if (optionEnd == NULL) {
+          optionEnd = valuesEnd;
+        }
+        if (value.equals(HTTPSpan(option, optionEnd - option))) {
+          return true;
+        }
+        option = optionEnd + 1;
+      }
+      return false;
+    }
+  }
+  return false;
+}
+
+bool URLParamConstraint::equals(URLParamConstraint const &other) const {
+  return _type == other._type && (_type != PARAM_ENUM || _values.equals(other._values));
+}
+
+} /* namespace httpsserver */
@@ -0,0 +1,105 @@
+#ifndef SRC_URLPARAMCONSTRAINT_HPP_
+#define SRC_URLPARAMCONSTRAINT_HPP_
+
+#include <Arduino.h>
+
+#include "HTTPSpan.hpp"
+
+namespace httpsserver {
+
+/**
+ * \brief Type of a URL parameter, checked by the router while it matches a path
+ *
+ * The '*' of a URL parameter can be followed by a type in braces, e.g. `*{uint}`. If the value in
+ * the request path does not have that type, the node does not match and the router continues with
+ * the next candidate, so the request never reaches a handler or the middleware. Supported types:
+ *
+ * - `*{int}`: Decimal integer with optional sign that fits into 64 bits
+ * - `*{uint}`: Decimal integer without sign that fits into 63 bits
+ * - `*{hex}`: Hexadecimal digits
+ * - `*{uuid}`: UUID in the form 01234567-89ab-cdef-0123-456789abcdef
+ * - `*{on|off}`: One of the listed values, separated by '|'
+ *
+ * Braces that contain neither a type name nor a '|' are no type. A warning is logged, and they are
+ * literal text of the path that has to follow the parameter.
+ *
+ * Parameters with a type are tried before parameters without a type at the same position.
+ *
+ * The constraint refers to the path of the node without copying it. The type can be parsed by the
+ * compiler (see StaticRoute), which is why the parser consists of constexpr functions.
+ */
+class URLParamConstraint {
+public:
+  enum Type {
+    /** Any value, the parameter has no type */
+    PARAM_ANY,
+    PARAM_INT,
+    PARAM_UINT,
+    PARAM_HEX,
+    PARAM_UUID,
+    /** One of the values in _values, separated by '|' */
+    PARAM_ENUM
+  };
+
+  constexpr URLParamConstraint(Type type = PARAM_ANY, HTTPSpan values = HTTPSpan()):
+    _type(type),
+    _values(values) {}
+
+  static size_t parse(const char * spec, size_t length, URLParamConstraint &constraint);
+
+  /**
+   * Returns the number of characters of the type (including the braces) at the beginning of spec,
+   * which is the text that follows the '*', or 0 if the parameter has no type.
+   */
+  static constexpr size_t specLength(const char * spec, size_t length) {
+    return (bracesLength(spec, length) == 0 || typeOf(spec + 1, bracesLength(spec, length) - 2) == PARAM_ANY) ?
+      0 : bracesLength(spec, length);
+  }
+
+  /** Returns the constraint for the type at the beginning of spec, see specLength() */
+  static constexpr URLParamConstraint fromSpec(const char * spec, size_t length) {
+    return specLength(spec, length) == 0 ? URLParamConstraint() :
+      typeOf(spec + 1, specLength(spec, length) - 2) == PARAM_ENUM ?
+        URLParamConstraint(PARAM_ENUM, HTTPSpan(spec + 1, specLength(spec, length) - 2)) :
+        URLParamConstraint(typeOf(spec + 1, specLength(spec, length) - 2));
+  }
+
+  bool accepts(HTTPSpan const &value) const;
+  bool equals(URLParamConstraint const &other) const;
+  constexpr Type getType() const { return _type; }
+
+private:
+  // C++11 allows only a single return statement in constexpr functions, hence the recursion
+  static constexpr size_t closingBrace(const char * spec, size_t length, size_t i = 1) {
+    return i >= length ? 0 : (spec[i] == '}' ? i : closingBrace(spec, length, i + 1));
+  }
+
+  /** Length of the non-empty text in braces at the beginning of spec (including the braces), or 0 */
+  static constexpr size_t bracesLength(const char * spec, size_t length) {
+    return (length < 2 || spec[0] != '{' || closingBrace(spec, length) <= 1) ? 0 : closingBrace(spec, length) + 1;
+  }
+
+  static constexpr bool containsBar(const char * name, size_t length, size_t i = 0) {
+    return i < length && (name[i] == '|' || containsBar(name, length, i + 1));
+  }
+
+  static constexpr bool nameIs(const char * name, size_t length, const char * str, size_t i = 0) {
+    return i == length ? str[i] == 0 : (str[i] == name[i] && nameIs(name, length, str, i + 1));
+  }
+
+  static constexpr Type typeOf(const char * name, size_t length) {
+    return nameIs(name, length, "int") ? PARAM_INT :
+      nameIs(name, length, "uint") ? PARAM_UINT :
+      nameIs(name, length, "hex") ? PARAM_HEX :
+      nameIs(name, length, "uuid") ? PARAM_UUID :
+      // Anything else is no type
+      containsBar(name, length) ? PARAM_ENUM : PARAM_ANY;
+  }
+
+  Type _type;
+  HTTPSpan _values;
+};
+
+} /* namespace httpsserver */
+
+#endif /* SRC_URLPARAMCONSTRAINT_HPP_ */
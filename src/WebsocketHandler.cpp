@@ -183,6 +183,7 @@ void WebsocketHandler::close(uint16_t status, std::string message) {
   if (rc > 0) {
     _con->writeBuffer((byte *) message.data(), message.length());
   }
+  _con->flushBuffer();
 } // Websocket::close
 
 /**
@@ -211,6 +212,7 @@ void WebsocketHandler::send(std::string data, uint8_t sendType) {
     _con->writeBuffer((uint8_t *)&net_len, sizeof(uint16_t));  // Convert to network byte order from host byte order
   }
   _con->writeBuffer((uint8_t*)data.data(), data.length());
+  _con->flushBuffer();
   HTTPS_LOGD("<< Websocket.send()");
 } // Websocket::send
 
@@ -238,9 +240,10 @@ void WebsocketHandler::send(uint8_t* data, uint16_t length, uint8_t sendType) {
     frame.len = 126;
     _con->writeBuffer((uint8_t *)&frame, sizeof(frame));
     uint16_t net_len = htons(length);
-    _con->writeBuffer((uint8_t *) net_len, sizeof(uint16_t));  // Convert to network byte order from host byte order
+    _con->writeBuffer((uint8_t *)&net_len, sizeof(uint16_t));  // Convert to network byte order from host byte order
   }
   _con->writeBuffer(data, length);
+  _con->flushBuffer();
   HTTPS_LOGD("<< Websocket.send()");
 }  // Websocket::send
 
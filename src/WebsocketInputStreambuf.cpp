@@ -43,11 +43,20 @@ WebsocketInputStreambuf::~WebsocketInputStreambuf() {
  * need to be consumed/discarded before we can move on to the next record.
  */
 void WebsocketInputStreambuf::discard() {
-  uint8_t byte;
   HTTPS_LOGD(">> WebsocketContext.discard(): %d bytes", _dataLength - _sizeRead);
   while(_sizeRead < _dataLength) {
-    _con->readBuffer(&byte, 1);
-    _sizeRead++;
+    // Drop the data directly from the connection's buffer, there's no need to copy it
+    uint8_t * data;
+    size_t length = _con->peekBuffer(&data);
+    if (length == 0) {
+      HTTPS_LOGW("WS record truncated, %u bytes could not be discarded", (unsigned)(_dataLength - _sizeRead));
+      break;
+    }
+    if (length > _dataLength - _sizeRead) {
+      length = _dataLength - _sizeRead;
+    }
+    _con->consumeBuffer(length);
+    _sizeRead += length;
   }
   HTTPS_LOGD("<< WebsocketContext.discard()");
 } // WebsocketInputStreambuf::discard
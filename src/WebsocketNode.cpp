@@ -3,7 +3,7 @@
 namespace httpsserver {
 
 WebsocketNode::WebsocketNode(const std::string &path, const WebsocketHandlerCreator * creatorFunction, const std::string &tag):
-  HTTPNode(path, WEBSOCKET, tag),
+  HTTPNode(path, WEBSOCKET, tag, METHOD_GET),
   _creatorFunction(creatorFunction) {
 
 }
@@ -43,8 +43,11 @@ std::string intToString(int i) {
   if (i==0) {
     return "0";
   }
-  // We need this much digits
-  int digits = ceil(log10(i));
+  // We need this much digits (log10 would be off by one for powers of ten)
+  int digits = 0;
+  for(int x = i; x != 0; x /= 10) {
+    digits++;
+  }
   char c[digits+1];
   c[digits] = '\0';
 
@@ -57,4 +60,52 @@ std::string intToString(int i) {
   return std::string(c);
 }
 
+const char * findChar(const char * data, size_t length, char c) {
+#if defined(__XTENSA__)
+  return findCharWordwise(data, length, c);
+#else
+  return (const char *)memchr(data, c, length);
+#endif
+}
+
+const char * findCharWordwise(const char * data, size_t length, char c) {
+  typedef uint32_t word_t;
+  const char * end = data + length;
+
+  // Word access must be aligned on the ESP32, so we check byte by byte until we reach a word boundary
+  for(; data < end && ((uintptr_t)data & (sizeof(word_t) - 1)) != 0; data++) {
+    if (*data == c) {
+      return data;
+    }
+  }
+
+  // XOR with the pattern turns matching bytes into zero bytes. The expression (x - 0x01..) & ~x & 0x80..
+  // sets the high bit of each zero byte. Bits above the first zero byte may be set by the borrow, so
+  // only the lowest match is reliable, which is the one we're looking for on little-endian machines.
+  const word_t ones = ((word_t)-1) / 0xFF;
+  const word_t highs = ones * 0x80;
+  const word_t pattern = ones * (unsigned char)c;
+  while(end - data >= (ptrdiff_t)sizeof(word_t)) {
+    word_t word;
+    memcpy(&word, data, sizeof(word_t));
+    word_t x = word ^ pattern;
+    word_t found = (x - ones) & ~x & highs;
+    if (found != 0) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return data + (__builtin_ctz(found) >> 3);
+#else
+      break;
+#endif
+    }
+    data += sizeof(word_t);
+  }
+
+  for(; data < end; data++) {
+    if (*data == c) {
+      return data;
+    }
+  }
+  return NULL;
+}
+
 }
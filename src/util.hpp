@@ -25,6 +25,22 @@ int32_t parseInt(std::string const &s);
  */
 std::string intToString(int i);
 
+/**
+ * \brief **Utility function**: Find the first occurrence of a character in a buffer
+ *
+ * Works like memchr(). It is used by the HTTP parser to find the next \\r, ':' or ' ' in a line.
+ * On the ESP32 (Xtensa), where memchr() compares byte by byte, findCharWordwise() is used. Other
+ * platforms have an optimized memchr(), which is used directly.
+ *
+ * Returns NULL if the character is not found.
+ */
+const char * findChar(const char * data, size_t length, char c);
+
+/**
+ * \brief **Utility function**: Portable word-at-a-time implementation of findChar()
+ */
+const char * findCharWordwise(const char * data, size_t length, char c);
+
 }
 
 #endif /* SRC_UTIL_HPP_ */